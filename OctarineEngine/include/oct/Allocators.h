@@ -6,9 +6,15 @@
 extern "C" {
 #endif
 
+/// \brief Alignment of every oct_Malloc/oct_Zalloc allocation out of an arena or virtual page allocator
+#define OCT_ALLOCATION_ALIGNMENT 16
+
+/// \brief Address space oct_CreateVirtualArenaAllocator reserves if it isn't given a size (64gb)
+#define OCT_DEFAULT_VIRTUAL_ARENA_RESERVE ((int64_t)64 * 1024 * 1024 * 1024)
+
 /// \brief Creates a general-purpose heap allocator
 /// \return Returns a new heap, or NULL if it fails
-/// \warning You may malloc from this heap on the thread that created it
+/// \warning You may malloc from this heap on the thread that created it, but oct_Free may be called from any thread.
 OCTARINE_API Oct_Allocator oct_CreateHeapAllocator();
 
 /// \brief Creates a new arena allocator, a fast allocator that may only be destroyed all at once
@@ -18,15 +24,56 @@ OCTARINE_API Oct_Allocator oct_CreateHeapAllocator();
 /// to do so from multiple different threads concurrently.
 OCTARINE_API Oct_Allocator oct_CreateArenaAllocator(int32_t size);
 
+/// \brief Creates an arena allocator that grows in place as it's used, up to a size reserved up front
+/// \param reserve Most the arena can ever hold, 0 for OCT_DEFAULT_VIRTUAL_ARENA_RESERVE
+/// \return Returns the new arena allocator, or null if it fails
+/// \warning Arena allocations may be made from any thread but it is not thread safe
+/// to do so from multiple different threads concurrently.
+///
+/// This reserves reserve bytes of address space without using any memory, and memory is only committed as the arena
+/// fills up. The arena is one contiguous block that never moves, so unlike a virtual page allocator, big allocations
+/// never leave the rest of a page unused and an oct_Realloc of the last allocation can always grow in place. Resetting
+/// the arena gives memory past the most it used since the last reset back to the OS. The reserve can be huge since it
+/// only costs address space, this is only really limited on 32-bit platforms. It's otherwise a regular arena,
+/// oct_GetAllocatorType returns OCT_ALLOCATOR_TYPE_ARENA.
+OCTARINE_API Oct_Allocator oct_CreateVirtualArenaAllocator(int64_t reserve);
+
 /// \brief Creates a "virtual page" allocator that is good at being reset often but still allows arbitrary allocations
 /// \return Returns a new virtual page allocator, or NULL if it fails
 /// \warning Arena allocations may be made from any thread but it is not thread safe
 /// to do so from multiple different threads concurrently.
 ///
 /// This is an allocator that allows for arbitrary allocations but still allows you to empty it out very quickly like
-/// an arena. This is for memory you don't know the size of and won't be around very long.
+/// an arena. This is for memory you don't know the size of and won't be around very long. Allocations only ever come
+/// from the current page and pages are reused in the same order after a reset, so allocating is constant time no
+/// matter how many pages the allocator has grown to.
 OCTARINE_API Oct_Allocator oct_CreateVirtualPageAllocator();
 
+/// \brief Creates a pool allocator for many elements of the same size that come and go often
+/// \param elementSize Size of each element, every allocation from the pool must be at most this big
+/// \param elementsPerBlock Number of elements the pool starts with and grows by each time it runs out
+/// \return Returns the new pool allocator, or null if it fails
+/// \warning Allocations may only be made from one thread at a time, but oct_Free may be called from any thread.
+///
+/// This is meant for things like bullets, particles, or entities that are constantly being made and destroyed.
+/// Allocating and freeing are both constant time and elements are aligned to OCT_ALLOCATION_ALIGNMENT. Freeing is
+/// lock-free so jobs can free elements the allocating thread gave out without any coordination.
+OCTARINE_API Oct_Allocator oct_CreatePoolAllocator(int32_t elementSize, int32_t elementsPerBlock);
+
+/// \brief Gets how full a pool allocator is
+/// \param allocator Pool allocator to check
+/// \param used Filled with the number of elements allocated
+/// \param capacity Filled with the number of elements the pool has room for before it grows
+///
+/// Both are 0 if the allocator isn't a pool.
+OCTARINE_API void oct_GetPoolOccupancy(Oct_Allocator allocator, int32_t *used, int32_t *capacity);
+
+/// \brief Gets statistics about how much memory an allocator is using
+/// \param allocator Allocator to check
+/// \param stats Filled with the allocator's stats
+/// \warning This isn't thread safe for allocators that are being allocated from on another thread, besides pools.
+OCTARINE_API void oct_GetAllocatorStats(Oct_Allocator allocator, Oct_AllocatorStats *stats);
+
 /// \brief Returns the type of allocator this is
 /// \param allocator Allocator to check
 /// \return Returns one of the OCT_ALLOCATOR_TYPE_* enums
@@ -53,14 +100,45 @@ OCTARINE_API void oct_FreeAllocator(Oct_Allocator allocator);
 /// This is supported by all allocator types.
 OCTARINE_API void *oct_Malloc(Oct_Allocator allocator, int32_t size);
 
+/// \brief Allocator equivalent of malloc with a specific alignment
+/// \param allocator Allocator to use
+/// \param size Size of the allocation
+/// \param align Alignment of the allocation, must be a power of 2
+/// \return Returns the new allocation, or null if it fails
+///
+/// This is supported by all allocator types. Arenas and virtual page allocators already align everything to
+/// OCT_ALLOCATION_ALIGNMENT, this is for when something needs more than that (cache lines, SIMD buffers).
+OCTARINE_API void *oct_MallocAligned(Oct_Allocator allocator, int32_t size, int32_t align);
+
 /// \brief Allocator equivalent of realloc
 /// \param allocator Allocator to use
 /// \param memory Original allocation
 /// \param size Size of the new allocation
 /// \return Returns the new allocation, or null if it fails
-/// \warning Only heap allocators may use this.
+///
+/// On arenas and virtual page allocators the most recent allocation is grown or shrunk in place if there is room,
+/// anything else is copied into a new allocation (the old one isn't reclaimed until a reset or rewind). Pools can
+/// only "reallocate" to sizes that still fit in an element.
 OCTARINE_API void *oct_Realloc(Oct_Allocator allocator, void *memory, int32_t size);
 
+/// \brief Gets a mark of how much of an arena or virtual page allocator is currently in use
+/// \param allocator Allocator to mark
+/// \return Returns a mark that can be passed to oct_AllocatorRewind, always 0 for other allocator types
+///
+/// Marks let nested temporary work give back just its own memory. For example, a pathfinding query in the middle of
+/// an AI update can mark the frame's scratch allocator, allocate as much as it needs, and rewind to the mark when it's
+/// done so the rest of the frame reuses that memory while everything allocated before the mark stays put.
+OCTARINE_API Oct_AllocatorMark oct_AllocatorMark(Oct_Allocator allocator);
+
+/// \brief Frees everything allocated out of an arena or virtual page allocator since a mark was made
+/// \param allocator Allocator the mark came from
+/// \param mark Mark from oct_AllocatorMark
+/// \warning This invalidates all memory allocated after the mark was made, and every mark made after it. Marks
+/// made before the last reset of the allocator are invalid.
+///
+/// Does nothing on other allocator types.
+OCTARINE_API void oct_AllocatorRewind(Oct_Allocator allocator, Oct_AllocatorMark mark);
+
 /// \brief Same as oct_HeapAllocatorMalloc, but zeros the data
 /// \param allocator Allocator to allocate from
 /// \param size Size of the allocation
@@ -69,10 +147,10 @@ OCTARINE_API void *oct_Realloc(Oct_Allocator allocator, void *memory, int32_t si
 /// This is supported by all allocator types.
 OCTARINE_API void *oct_Zalloc(Oct_Allocator allocator, int32_t size);
 
-/// \brief Frees an allocation out of a heap allocator
+/// \brief Frees an allocation out of a heap or pool allocator
 /// \param allocator Allocator the memory came from
 /// \param memory Memory to free
-/// \warning Only heap allocators may free individual allocations.
+/// \warning Only heap and pool allocators may free individual allocations.
 OCTARINE_API void oct_Free(Oct_Allocator allocator, void *memory);
 
 #ifdef __cplusplus
@@ -11,10 +11,13 @@ extern "C" {
 /// \return Returns a new asset ID
 ///
 /// This will add a load command to the command queue. The asset is not immediately
-/// loaded and will be loaded whenever the render thread receives the command. This is
-/// guaranteed to be before the next draw command is executed unless the load fails for
-/// any reason. What this means in practice is that this function does not immediately
-/// load the asset but you may treat the asset as thought it were.
+/// loaded and will be loaded whenever the render thread gets to the command. Loads go
+/// through the load lane and may be spread over several frames (see oct_SetCommandLaneBudget),
+/// but any draw or sound that uses the asset makes the render thread finish the load first,
+/// unless the load fails for any reason. What this means in practice is that this function
+/// does not immediately load the asset but you may treat the asset as thought it were, at
+/// the cost of a possible hitch if the load lane is behind. The same goes for every load
+/// shorthand below.
 ///
 /// Assets in Octarine are just 64-bit integers. They internally index an asset array
 /// but also their more significant 32 bits represent their generation which means that
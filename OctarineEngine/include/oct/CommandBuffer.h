@@ -8,9 +8,61 @@ extern "C" {
 
 /// \brief Queues a draw command
 ///
-/// This is thread safe
+/// This is thread safe. Draws made from inside a job are recorded by the thread running the job and merged into the
+/// frame at the end of the frame, after the logic thread's own draws, sorted by the key from oct_SetDrawSortKey.
+/// Every job that draws must be finished before update returns.
 OCTARINE_API void oct_Draw(Oct_DrawCommand *draw);
 
+/// \brief Queues many draw commands at once
+/// \param draws Array of draw commands, they are copied so the array may be reused right away
+/// \param count Number of draw commands in the array
+///
+/// This is thread safe and behaves exactly like calling oct_Draw on each command in order, but the whole array goes
+/// to the render thread as a single entry in the command buffer instead of one per draw. Prefer this when you're
+/// drawing hundreds or thousands of things at once.
+OCTARINE_API void oct_DrawBatch(const Oct_DrawCommand *draws, int32_t count);
+
+/// \brief Sets the sort key for draws made from the current job
+/// \param layer Draws on lower layers are drawn first
+/// \param index Draws with a lower index on the same layer are drawn first
+///
+/// Draws with the same key are drawn in the order their jobs were queued, and draws from the same job in the order
+/// they were made. The key belongs to the job and lasts until it's set again or the job finishes. Jobs start out on
+/// the layer of whatever queued them with their submission index as the index, and draws from an oct_ParallelFor are
+/// kept in item order, so the draw order is the same every frame no matter how the jobs were spread across threads.
+/// Submission indices are only deterministic for jobs queued from one thread (usually the logic thread), jobs queued
+/// from inside several other jobs at once should set a key. This does nothing outside of jobs.
+OCTARINE_API void oct_SetDrawSortKey(int32_t layer, int32_t index);
+
+/// \brief Gets statistics about how full the command buffer gets
+/// \param stats Filled with the stats, they're updated once a second
+///
+/// Commands go to the render thread through a ring buffer that starts out the size of Oct_InitInfo::ringBufferSize.
+/// When it fills up, whichever thread is queueing commands waits for the render thread to make room and the buffer
+/// is doubled in size the next time it's empty. If stalls are showing up regularly, a bigger starting ringBufferSize
+/// based on peakOccupancy will avoid them.
+OCTARINE_API void oct_GetCommandBufferStats(Oct_CommandBufferStats *stats);
+
+/// \brief Sets how long the render thread may spend on a command lane each frame
+/// \param lane Lane to set the budget of, the budget of OCT_COMMAND_LANE_DRAW is ignored
+/// \param budget Seconds per render frame, 0 for no limit
+///
+/// Once a lane has used up its budget for the frame, the rest of its commands wait for the next frame (in order),
+/// this way a burst of asset loads gets spread over several frames instead of causing one long hitch. At least one
+/// command of each lane is processed every frame, so a single load that takes longer than the budget still goes
+/// through. Draw and meta commands are never held back so draws always show up in the frame they were sent in.
+/// By default the load lane gets 4ms per frame and every other lane is unlimited. This is thread safe.
+///
+/// Commands are only kept in order within a lane, with one exception: a draw or sound that uses an asset whose load
+/// is still queued in the load lane first processes the load lane up to that load, going over its budget if it has
+/// to. So oct_LoadTexture followed by oct_DrawTexture in the same frame still draws the texture, but that frame may
+/// hitch. Loads you don't need right away should be sent a few frames before they're used, or waited on with
+/// oct_AssetLoaded.
+OCTARINE_API void oct_SetCommandLaneBudget(Oct_CommandLane lane, double budget);
+
+/// \brief Returns the number of commands in a lane that are waiting on the lane's budget
+OCTARINE_API int32_t oct_GetCommandLaneBacklog(Oct_CommandLane lane);
+
 /// \brief Queues a window update
 ///
 /// This is thread safe
@@ -33,7 +85,8 @@ OCTARINE_API Oct_Asset oct_Load(Oct_LoadCommand *load);
 /// expect to be destroyed very soon. In that case, you can copy that string into this function and use the pointer
 /// returned by this instead. This memory is guaranteed to exist until the render thread has finished processing.
 /// The shorthand functions, like oct_LoadTexture will use this automatically under the hood, and you'd only ever
-/// need to use this if you were creating your own commands.
+/// need to use this if you were creating your own commands. This is thread safe, and from job threads or the logic
+/// thread it doesn't take any locks.
 OCTARINE_API void *oct_CopyFrameData(void *data, int32_t size);
 
 #ifdef __cplusplus
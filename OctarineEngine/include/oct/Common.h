@@ -72,11 +72,14 @@ typedef Oct_Asset Oct_Font;      ///< TrueType font (just the font itself)
 typedef Oct_Asset Oct_FontAtlas; ///< A bitmap font
 typedef Oct_Asset Oct_Camera;    ///< Camera that shows some portion of the game world
 typedef uint64_t Oct_Sound;      ///< A sound that is currently playing (oct_Audio is the raw audio data, Oct_Sound is a currently playing piece of audio)
+typedef uint64_t Oct_Job;        ///< Handle to a job queued in the job system
+typedef uint64_t Oct_AllocatorMark; ///< Point in an arena or virtual page allocator that can be rewound to
 typedef float Oct_Vec4[4];       ///< Array of 4 floats
 typedef float Oct_Vec3[3];       ///< Array of 3 floats
 typedef float Oct_Vec2[2];       ///< Array of 2 floats
 typedef void (*Oct_FileHandleCallback)(void*,uint32_t); ///< Callback for a file handle
 typedef void (*Oct_JobFunction)(void*); ///< Function pointer for a job in the job system
+typedef void (*Oct_ParallelForFunction)(int32_t,int32_t,void*); ///< Function pointer for a range [start, end) of a parallel for in the job system
 
 ////////////////////// Enums //////////////////////
 /// \brief Structure types
@@ -166,8 +169,25 @@ typedef enum {
     OCT_ALLOCATOR_TYPE_HEAP = 1,         ///< General-purpose heap allocator
     OCT_ALLOCATOR_TYPE_ARENA = 2,        ///< Arena allocator
     OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE = 3, ///< Virtual page allocator
+    OCT_ALLOCATOR_TYPE_POOL = 4,         ///< Pool of same-sized elements
 } Oct_AllocatorType;
 
+/// \brief Priority lanes jobs can be queued in
+typedef enum {
+    OCT_JOB_PRIORITY_CRITICAL = 0,   ///< Work the current frame depends on, always taken first
+    OCT_JOB_PRIORITY_BACKGROUND = 1, ///< Long running work like asset decoding that may take several frames
+    OCT_JOB_PRIORITY_MAX = 2,        ///< For iteration
+} Oct_JobPriority;
+
+/// \brief Lanes the render thread dispatches commands in
+typedef enum {
+    OCT_COMMAND_LANE_DRAW = 0,   ///< Draw and meta commands, always dispatched in full every frame
+    OCT_COMMAND_LANE_AUDIO = 1,  ///< Audio commands
+    OCT_COMMAND_LANE_WINDOW = 2, ///< Window commands
+    OCT_COMMAND_LANE_LOAD = 3,   ///< Asset loads and frees
+    OCT_COMMAND_LANE_MAX = 4,    ///< For iteration
+} Oct_CommandLane;
+
 /// \brief Types of assets stored in an Oct_Asset
 typedef enum {
     OCT_ASSET_TYPE_NONE = 0,       ///< None
@@ -226,7 +246,7 @@ struct Oct_InitInfo_t {
     const char *windowTitle;                     ///< Title of the window
     int windowWidth;                             ///< Window width
     int windowHeight;                            ///< Window height
-    int32_t ringBufferSize;                      ///< Size of the draw command ring buffer, if 0 this will be 1000
+    int32_t ringBufferSize;                      ///< Minimum number of commands the command ring buffer can hold at first (it grows if it fills up), if 0 this will be 1000
     int logicHz;                                 ///< Refresh rate of the logic thread, 0 will set this to 30
     Oct_Bool debug;                              ///< Enables debug features
     int argc;                                    ///< Command line parameters
@@ -234,6 +254,9 @@ struct Oct_InitInfo_t {
     void *(*startup)();                          ///< Function pointer to the startup function
     void *(*update)(void *ptr);                  ///< Function pointer to the update function
     void(*shutdown)(void *ptr);                  ///< Function pointer to the shutdown function
+    int32_t jobThreadCount;                      ///< Number of job threads, if 0 this will be picked from the core count
+    Oct_Bool pinThreads;                         ///< Pins the render, logic, audio mixer, and job threads to their own cores out of the cores the process is allowed on, threads past that many aren't pinned (Linux only)
+    const char *captureFile;                     ///< If not null, every command sent to the render thread is written to this file so it can be replayed with oct_Replay
     void *pNext;                                 ///< For future use
 };
 
@@ -386,6 +409,24 @@ struct Oct_SpriteInstance_t {
     Oct_Sprite spr;     ///< Sprite this is associated with
 };
 
+/// \brief Statistics about the command buffer between the logic and render thread, see oct_GetCommandBufferStats
+struct Oct_CommandBufferStats_t {
+    int32_t capacity;         ///< Current size of the command buffer in bytes
+    int32_t peakOccupancy;    ///< Most bytes of the command buffer in use at once over the last second
+    int32_t grows;            ///< Number of times the command buffer has grown since startup
+    double stallsPerFrame;    ///< Average number of times per frame a thread found the buffer full over the last second
+    double stallTimePerFrame; ///< Average seconds per frame threads spent waiting on a full buffer over the last second
+};
+
+/// \brief Statistics about an allocator from oct_GetAllocatorStats
+struct Oct_AllocatorStats_t {
+    int64_t bytesAllocated;     ///< Bytes currently allocated, for arenas and virtual page allocators this includes alignment padding
+    int64_t bytesReserved;      ///< Bytes the allocator is holding on to whether they're allocated or not, same as bytesAllocated for heaps
+    int64_t peakBytesAllocated; ///< Most bytes allocated at once since the allocator was created
+    int32_t pageCount;          ///< Pages in a virtual page allocator or blocks in a pool, 1 for arenas and 0 for heaps
+    int32_t allocationCount;    ///< Allocations since the last reset for arenas and virtual page allocators, live allocations for heaps and pools
+};
+
 ////////////////////// User structs //////////////////////
 OCT_USER_STRUCT(Oct_InitInfo)
 OCT_USER_STRUCT(Oct_DrawCommand)
@@ -400,6 +441,8 @@ OCT_USER_STRUCT(Oct_Rectangle)
 OCT_USER_STRUCT(Oct_Circle)
 OCT_USER_STRUCT(Oct_Colour)
 OCT_USER_STRUCT(Oct_SpriteInstance)
+OCT_USER_STRUCT(Oct_CommandBufferStats)
+OCT_USER_STRUCT(Oct_AllocatorStats)
 
 /// \brief Draw command to draw anything
 struct Oct_DrawCommand_t {
@@ -433,6 +476,7 @@ struct Oct_DrawCommand_t {
         struct {
             Oct_Shader shader;      ///< Shader to use
             void *uniformData;      ///< Data passed to the shader
+            uint32_t uniformSize;   ///< Size of uniformData in bytes, must be set for the uniforms to be in a command capture
             Oct_Texture texture;    ///< Texture to draw
             Oct_Rectangle viewport; ///< Where in the texture to draw (use OCT_WHOLE_TEXTURE)
             Oct_Vec2 position;      ///< Where on the game world to draw it
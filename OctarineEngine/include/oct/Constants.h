@@ -32,6 +32,7 @@ extern int32_t OCT_SPRITE_FIRST_FRAME; ///< Draw the first frame of the animatio
 extern Oct_Asset OCT_TARGET_SWAPCHAIN;  ///< Target the swapchain (window)
 extern Oct_Asset OCT_NO_ASSET;          ///< For things like specifying a new texture in sprite creation
 extern Oct_Sound OCT_SOUND_FAILED;      ///< Sound was failed to be played
+extern Oct_Job OCT_NO_JOB;              ///< A job that is always complete
 extern int32_t OCT_MINIMUM_JOB_THREADS; ///< Minimum number of job threads
 
 #ifdef __cplusplus
@@ -10,6 +10,18 @@ extern "C" {
 /// \param initInfo Info needed to initialize
 OCTARINE_API Oct_Status oct_Init(Oct_InitInfo *initInfo);
 
+/// \brief Starts the engine and renders a command capture instead of running a game
+/// \param initInfo Info needed to initialize, startup/update/shutdown are not used
+/// \param captureFile Capture made by running a game with Oct_InitInfo::captureFile set
+/// \param timingsFile If not null, the time each frame took is written here as a csv
+/// \return Returns OCT_STATUS_SUCCESS once every frame was replayed or the window was closed
+///
+/// Every captured logic frame is fed to the drawing, audio, and asset subsystems and rendered right away with no
+/// frame limit, so this measures only the render side of the game. The average, median, 99th percentile, and worst
+/// frame times are logged when it's done. Captures are raw engine structs, so they can only be replayed by the same
+/// build of Octarine that made them.
+OCTARINE_API Oct_Status oct_Replay(Oct_InitInfo *initInfo, const char *captureFile, const char *timingsFile);
+
 /// \brief Returns the framerate of the render thread
 OCTARINE_API double oct_GetRenderFPS();
 
@@ -186,6 +186,27 @@ OCTARINE_API void oct_DrawSpriteFrameExt(Oct_Sprite sprite, int32_t frame, Oct_V
 /// \brief Draw a specific sprite frame (use SPRITE_*_FRAME, otherwise index from 0)
 OCTARINE_API void oct_DrawSpriteFrameColourExt(Oct_Sprite sprite, int32_t frame, Oct_Colour *colour, Oct_Vec2 position, Oct_Vec2 scale, float rotation, Oct_Vec2 origin);
 
+/// \brief Draws many rectangles at once, see oct_DrawBatch
+OCTARINE_API void oct_DrawRectangleBatch(const Oct_Rectangle *rectangles, int32_t count, Oct_Bool filled, float lineWidth);
+
+/// \brief Draws a texture at many positions at once, see oct_DrawBatch
+OCTARINE_API void oct_DrawTextureBatch(Oct_Texture texture, const Oct_Vec2 *positions, int32_t count);
+
+/// \brief Draws the same sprite frame at many positions at once, see oct_DrawBatch
+OCTARINE_API void oct_DrawSpriteFrameBatch(Oct_Sprite sprite, int32_t frame, const Oct_Vec2 *positions, int32_t count);
+
+/// \brief Draws a sprite for many instances at once, see oct_DrawBatch
+/// \param interp Interpolation used for every sprite
+/// \param ids Interpolation ID of each sprite, may be null if interp is 0
+/// \param sprite Sprite to draw
+/// \param instances Each sprite's instance, they are all updated like oct_DrawSpriteInt would
+/// \param positions Each sprite's position
+/// \param count Number of sprites to draw
+OCTARINE_API void oct_DrawSpriteBatchInt(Oct_InterpolationType interp, const uint64_t *ids, Oct_Sprite sprite, Oct_SpriteInstance *instances, const Oct_Vec2 *positions, int32_t count);
+
+/// \brief Draws a sprite for many instances at once, see oct_DrawBatch
+OCTARINE_API void oct_DrawSpriteBatch(Oct_Sprite sprite, Oct_SpriteInstance *instances, const Oct_Vec2 *positions, int32_t count);
+
 /// \brief Interpolates a camera update
 OCTARINE_API void oct_UpdateCameraInt(Oct_InterpolationType interp, uint64_t id, Oct_Camera camera, Oct_CameraUpdate *update);
 
@@ -7,18 +7,108 @@ extern "C" {
 #endif
 
 /// \brief Queues a job to be completed
+/// \param job Function to run
+/// \param data Data passed to the function
+/// \return Returns a handle to the job that can be waited on or depended on
 ///
 /// Jobs are functions that will be completed (usually) on a job thread. There is no guarantee when the queued job
 /// will be completed/started or on what thread, as they go into a job queue (mostly, if the job queue is full, this
-/// function will just execute the job right away).
-OCTARINE_API void oct_QueueJob(Oct_JobFunction job, void *data);
+/// function will just execute the job right away and return OCT_NO_JOB).
+OCTARINE_API Oct_Job oct_QueueJob(Oct_JobFunction job, void *data);
+
+/// \brief Queues a job that will only start once every job in dependencies is complete
+/// \param job Function to run, may be null to make a job that only exists to be waited on/depended on
+/// \param data Data passed to the function
+/// \param dependencies List of jobs that must complete before this job starts, OCT_NO_JOB is allowed in the list
+/// \param dependencyCount Number of jobs in the dependency list
+/// \return Returns a handle to the job that can be waited on or depended on
+///
+/// This lets you describe work as a graph: job B can be queued after jobs A1..An and it will be scheduled by whichever
+/// of those finishes last, nothing polls for it. Dependencies that are already complete are ignored.
+OCTARINE_API Oct_Job oct_QueueJobAfter(Oct_JobFunction job, void *data, const Oct_Job *dependencies, int32_t dependencyCount);
+
+/// \brief Queues a job in a specific priority lane
+/// \param job Function to run, may be null to make a job that only exists to be waited on/depended on
+/// \param data Data passed to the function
+/// \param priority Lane to queue the job in
+/// \param dependencies List of jobs that must complete before this job starts, may be null if dependencyCount is 0
+/// \param dependencyCount Number of jobs in the dependency list
+/// \return Returns a handle to the job that can be waited on or depended on
+///
+/// oct_QueueJob and oct_QueueJobAfter queue into OCT_JOB_PRIORITY_CRITICAL. Job threads always take critical jobs
+/// before background jobs, but still start a background job every so often when there is a steady stream of critical
+/// work so background jobs can't be starved forever. Threads that help out while waiting on jobs (oct_WaitJob,
+/// oct_ParallelFor) only help with critical jobs, unless oct_WaitJob is waiting on a background job in which case it
+/// helps with both. oct_WaitJobs always helps with both.
+OCTARINE_API Oct_Job oct_QueueJobPriority(Oct_JobFunction job, void *data, Oct_JobPriority priority, const Oct_Job *dependencies, int32_t dependencyCount);
+
+/// \brief Queues a job that runs on its own fiber so it can be suspended while it waits on other jobs
+/// \param job Function to run
+/// \param data Data passed to the function
+/// \param priority Lane to queue the job in
+/// \param dependencies List of jobs that must complete before this job starts, may be null if dependencyCount is 0
+/// \param dependencyCount Number of jobs in the dependency list
+/// \return Returns a handle to the job that can be waited on or depended on
+/// \warning Scratch memory from oct_JobScratch should not be held across an oct_WaitJob in a fiber job, the job may
+/// resume on a different thread.
+///
+/// When a fiber job calls oct_WaitJob on a job that isn't done, the fiber is suspended and the thread running it goes
+/// on to run other jobs. Once the job it waited on is done the fiber job is queued again and resumes on whatever
+/// thread picks it up. This is meant for long jobs that fork and join work of their own, so they don't tie up a
+/// thread while they wait. Fibers are only supported on Linux, elsewhere this queues a regular job. Fiber jobs get a
+/// 256kb stack, and oct_WaitJobs/oct_ParallelFor inside a fiber job wait the normal way.
+OCTARINE_API Oct_Job oct_QueueFiberJob(Oct_JobFunction job, void *data, Oct_JobPriority priority, const Oct_Job *dependencies, int32_t dependencyCount);
+
+/// \brief Runs a function over the range [0, count) split across the job threads and waits for it to finish
+/// \param count Number of items
+/// \param grain Smallest number of items given to a single call of function, 0 picks one based on the thread count
+/// \param function Function to call with each range, it receives the start (inclusive), end (exclusive), and data
+/// \param data Data passed to the function
+///
+/// You don't need to chunk the range yourself: it starts as a single range on the calling thread and is halved
+/// whenever other threads are out of work to steal, so it balances itself even if some items cost much more than
+/// others. The calling thread works on the range too and then helps run other jobs until every item is done.
+OCTARINE_API void oct_ParallelFor(int32_t count, int32_t grain, Oct_ParallelForFunction function, void *data);
+
+/// \brief Returns true if the job is complete
+OCTARINE_API Oct_Bool oct_JobDone(Oct_Job job);
+
+/// \brief Waits until a specific job is complete, running queued jobs on the calling thread in the meantime
+OCTARINE_API void oct_WaitJob(Oct_Job job);
 
 /// \brief Returns true if there are any jobs currently executing/in queue
 OCTARINE_API Oct_Bool oct_JobsBusy();
 
-/// \brief Waits until all active jobs are complete
+/// \brief Waits until all active jobs are complete, running queued jobs on the calling thread in the meantime
 OCTARINE_API void oct_WaitJobs();
 
+/// \brief Returns the calling thread's scratch allocator for temporary memory
+/// \return Returns a virtual page allocator owned by the calling thread, or null if called from a thread without one
+/// \warning Memory from this allocator is only valid until the end of the current logic frame, and the allocator
+/// may only be used from the thread it was returned on.
+///
+/// Each job thread and the logic thread have their own scratch allocator, so allocating from it never takes a lock or
+/// touches the heap. Scratch allocators are reset automatically once per logic frame, just don't hold on to scratch
+/// memory across frames or hand the allocator to another thread.
+OCTARINE_API Oct_Allocator oct_JobScratch();
+
+/// \brief Writes the job system's activity from the last few logic frames as a Chrome trace_event json
+/// \param filename File to write the trace to, it can be opened in chrome://tracing or Perfetto
+/// \param frames Number of logic frames to include, at most 256
+/// \return Returns true if the trace was written
+/// \warning Octarine must be built with the OCTARINE_JOB_TRACE CMake option, otherwise nothing is recorded and this
+/// always returns false.
+///
+/// Each job run on a job thread or the logic thread shows up with its start/end time and in its args when it was
+/// queued, whether it was stolen, and how many jobs were left in its lane when it was taken. Each thread is named
+/// with how many jobs it has stolen and every logic frame start is marked.
+OCTARINE_API Oct_Bool oct_DumpJobTrace(const char *filename, int32_t frames);
+
+/// \brief Returns the number of jobs sitting in a priority lane's queues that haven't started yet
+///
+/// Jobs that are still waiting on their dependencies aren't in a queue yet and aren't counted.
+OCTARINE_API int32_t oct_GetJobBacklog(Oct_JobPriority priority);
+
 #ifdef __cplusplus
 };
-#endif
\ No newline at end of file
+#endif
@@ -11,6 +11,20 @@
 extern "C" {
 #endif
 
+/// \brief Header in front of every record in the command ring buffer, the command itself follows right after
+typedef struct Oct_CommandHeader_t {
+    SDL_AtomicInt ready;     ///< Position of the record + 1 once the producer is done writing it
+    int32_t size;            ///< Size of the whole record including this header, a multiple of OCT_COMMAND_ALIGNMENT
+    Oct_StructureType sType; ///< Type of command that follows, OCT_STRUCTURE_TYPE_NONE for padding at the end of the buffer
+    uint32_t position;       ///< Position of the record in the stream
+} Oct_CommandHeader;
+
+/// \brief Structure type of a command ring record holding a batch of draws, it never leaves the ring
+#define OCT_STRUCTURE_TYPE_DRAW_BATCH ((Oct_StructureType)1000)
+
+/// \brief Every record in the command ring buffer starts at a multiple of this
+#define OCT_COMMAND_ALIGNMENT 16
+
 /// \brief General engine context
 struct Oct_Context_t {
     SDL_Window *window;             ///< Game window
@@ -25,15 +39,25 @@ struct Oct_Context_t {
     SDL_AtomicInt logicProcessTime; ///< Time spent processing logic frames - sleep time
     SDL_AtomicInt interpolatedTime; ///< Estimated time it should be in the logic frame cycle, for interpolation, normalized 0-1 (the frame just started would be 0, the frame is just about done is close to 1)
     uint64_t gameStartTime;         ///< Time the logic thread started for the user to query time
+    Oct_Bool headless;              ///< Only the job system and command buffer are running, see _oct_StartHeadless
 
     struct {
-        Oct_Command *commands; ///< Internal buffer
-        SDL_AtomicInt head;    ///< The reading end of the buffer
-        SDL_AtomicInt tail;    ///< The writing end of the buffer
-        SDL_Mutex *tailLock;   ///< To allow for MPSC
-    } RingBuffer;              ///< Ring buffer for commands
+        uint8_t *buffer;    ///< Internal buffer of variable-length command records
+        int32_t capacity;   ///< Size of the buffer in bytes, always a power of 2
+        SDL_AtomicInt head; ///< Byte position of the reading end of the buffer, only the render thread touches this
+        SDL_AtomicInt tail; ///< Byte position of the writing end of the buffer, claimed by producers with a CAS
+    } RingBuffer;               ///< Ring buffer for commands
 };
 
+/// \brief Key draws made from a job are sorted by when the frame's recorded draws are merged, belongs to the job
+typedef struct Oct_DrawSortKey_t {
+    int32_t layer;       ///< Set with oct_SetDrawSortKey, 0 by default
+    int32_t index;       ///< Set with oct_SetDrawSortKey, the job's submission index by default
+    uint32_t submission; ///< Order the job was queued in during the frame, breaks ties between jobs with the same key
+    int32_t range;       ///< Start of the chunk for draws made from an oct_ParallelFor, 0 otherwise
+    int32_t sequence;    ///< Draws the job has recorded so far
+} Oct_DrawSortKey;
+
 /// \brief A frame of a sprite's animation
 typedef struct Oct_SpriteFrame_t {
     Oct_Vec2 position; ///< Position of this frame
@@ -119,18 +143,38 @@ typedef struct Oct_AssetData_t Oct_AssetData;
 
 /// \brief Any type of allocator
 struct Oct_Allocator_t {
-    Oct_AllocatorType type; ///< Type of allocator this is
+    Oct_AllocatorType type;  ///< Type of allocator this is
+    int64_t allocationCount; ///< Allocations since the last reset, or live allocations for heaps
+    int64_t heapBytes;       ///< Bytes allocated out of a heap
+    int64_t peakBytes;       ///< Most bytes allocated at once, for arenas and virtual page allocators this is only
+                             ///< checked on reset/rewind/stats since it can only go up in between
+    SDL_SpinLock heapLock;   ///< Guards the three counts above for heaps, which can be freed from any thread
     union {
         struct {
-            uint8_t *buffer; ///< Internal memory buffer
-            int32_t size;    ///< Size of this arena
-            int32_t point;   ///< Where the last allocation ended in the arena
+            uint8_t *buffer;   ///< Internal memory buffer
+            int64_t size;      ///< Size of this arena, for virtual arenas this is how much is committed
+            int64_t point;     ///< Where the last allocation ended in the arena
+            int64_t last;      ///< Where the last allocation started in the arena
+            int64_t reserved;  ///< Address space reserved for a virtual arena, 0 for regular arenas
+            int64_t highWater; ///< Furthest point has been since the last reset, only tracked for virtual arenas
         } arenaAllocator;
         mi_heap_t *heapAllocator; ///< Internal mimalloc heap
         struct {
-            Oct_Allocator *pages; ///< Arenas (pages)
+            Oct_Allocator *pages; ///< Arenas (pages), the ones after current are all empty
             int32_t count;        ///< Number of arenas
+            int32_t capacity;     ///< Size of the pages array
+            int32_t current;      ///< Page allocations are made from, pages before it are full until the next reset
         }virtualPageAllocator;
+        struct {
+            void *freeList;           ///< Free elements only the allocating thread takes from
+            void *remoteFree;         ///< Elements freed since the allocating thread last took them, used atomically
+            uint8_t **blocks;         ///< Blocks of elements
+            int32_t blockCount;       ///< Number of blocks
+            int32_t blockCapacity;    ///< Size of the blocks array
+            int32_t elementSize;      ///< Size of each element, a multiple of OCT_ALLOCATION_ALIGNMENT
+            int32_t elementsPerBlock; ///< Number of elements the pool grows by when it runs out
+            SDL_AtomicInt used;       ///< Number of elements currently allocated
+        } poolAllocator;
     };
 };
 
@@ -9,6 +9,20 @@ extern "C" {
 void _oct_ValidationInit();
 void _oct_ValidationEnd();
 Oct_Context _oct_GetCtx();
+void _oct_StartHeadless(Oct_InitInfo *initInfo); // Only jobs and the command buffer, for the benchmarks in tools/
+void _oct_StopHeadless();
+
+// If Oct_InitInfo::pinThreads is set each thread pins itself to the core for its slot, job thread i uses
+// OCT_THREAD_SLOT_JOBS + i. Slots are given the cores the process is allowed on in order, slots past the number of
+// allowed cores (and OCT_THREAD_SLOT_NONE) stay on every allowed core.
+#define OCT_THREAD_SLOT_NONE -1
+#define OCT_THREAD_SLOT_RENDER 0
+#define OCT_THREAD_SLOT_LOGIC 1
+#define OCT_THREAD_SLOT_AUDIO 2
+#define OCT_THREAD_SLOT_JOBS 3
+int32_t _oct_AllowedCoreCount(); // Number of cores the process was allowed to run on at startup
+int32_t _oct_CoreForThreadSlot(int32_t slot); // -1 if the slot isn't pinned to a single core
+void _oct_PinThread(int32_t slot); // Does nothing if pinning is disabled or not supported on this platform
 
 // The command buffer subsystem is effectively a ring buffer that allows lockless command communication between
 // the logic and render thread. The logic thread begins every frame with a "begin frame" command and ends that
@@ -22,6 +36,28 @@ void _oct_CommandBufferEnd();
 void _oct_CommandBufferDispatch(); // Handles all currently available commands in the buffer
 void *_oct_CopyIntoFrameMemory(void *data, int32_t size);
 void *_oct_GetFrameMemory(int32_t size);
+int32_t _oct_DrawCommandSize(Oct_DrawCommandType type); // Bytes of an Oct_DrawCommand a draw of this type uses, the rest of the union is never copied
+double _oct_CommandBufferGetAverageBytesPerFrame(); // Bytes of commands sent to the render thread per frame
+double _oct_CommandBufferGetAverageBytesSavedPerFrame(); // Bytes saved per frame compared to sending every command as a full Oct_Command
+void _oct_CommandBufferGetFrameMemoryStats(Oct_AllocatorStats *stats); // Frame memory the last frame used, summed over every thread's allocator
+int32_t _oct_CommandBufferGetFrameMemoryHistory(float *history, int32_t count); // Bytes of frame memory each of the last count (at most 120) frames used, oldest first
+
+// Command capture writes every command the render thread dispatches to Oct_InitInfo::captureFile so the render side
+// can be replayed without the logic thread by oct_Replay
+void _oct_CaptureInit();
+void _oct_CaptureCommand(void *command, int32_t size); // Render thread only, does nothing if there is no capture file
+void _oct_CaptureEnd();
+Oct_Bool _oct_ReplayOpen(const char *filename);
+Oct_Bool _oct_ReplayFrame(); // Feeds the next logic frame from the capture to the subsystems, false once there are none left
+void _oct_ReplayClose();
+
+// Rewrites a command's pointers as offsets into a blob of what they point to (file buffers only if copyBuffers is set)
+// and back, the blob returned is only valid until the next pack. Render thread only.
+uint32_t _oct_CommandPackPointers(void *command, Oct_Bool copyBuffers, void **blob);
+void _oct_CommandUnpackPointers(void *command, void *blob, Oct_Bool copyBuffers);
+
+// Allocators
+int32_t _oct_AllocatorBytesUsed(Oct_Allocator allocator); // Bytes currently allocated out of an arena, virtual page, or pool allocator, 0 for heaps
 
 // Drawing subsystem is responsible for all rendering, its basically a wrapper over VK2D. Drawing commands are
 // different because they are not immediately processed, they are stored in a triple buffer by the drawing subsystem
@@ -31,7 +67,7 @@ void *_oct_GetFrameMemory(int32_t size);
 void _oct_DrawingInit();
 void _oct_DrawingUpdateBegin();
 void _oct_DrawingUpdateEnd();
-void _oct_DrawingProcessCommand(Oct_Command *cmd);
+void _oct_DrawingProcessCommand(void *command);
 double _oct_DrawingGetAverageInterpolationCalls();
 double _oct_DrawingGetAverageInterpolationTime();
 void _oct_DrawingEnd();
@@ -42,7 +78,7 @@ typedef struct Oct_WindowEvent_t Oct_WindowEvent;
 void _oct_WindowInit();
 void _oct_WindowUpdateBegin();
 void _oct_WindowUpdateEnd();
-void _oct_WindowProcessCommand(Oct_Command *cmd);
+void _oct_WindowProcessCommand(void *command);
 Oct_Bool _oct_WindowPopEvent(Oct_WindowEvent *event); // Used from the logic thread to pull key events, returns false if there are no more events (event is not valid in this case)
 void _oct_WindowEnd();
 
@@ -50,7 +86,7 @@ void _oct_WindowEnd();
 void _oct_AudioInit();
 void _oct_AudioUpdateBegin();
 void _oct_AudioUpdateEnd();
-void _oct_AudioProcessCommand(Oct_Command *cmd);
+void _oct_AudioProcessCommand(void *command);
 Oct_Sound _oct_ReserveSound(); // used from logic thread to reserve a space in the sound list
 SDL_AudioSpec *_oct_GetDeviceAudioSpec(); // returns the audio device spec
 void _oct_PlaySoundInternal(Oct_Audio id);
@@ -64,7 +100,7 @@ void _oct_AudioEnd();
 struct Oct_AssetData_t;
 typedef struct Oct_AssetData_t Oct_AssetData;
 void _oct_AssetsInit();
-void _oct_AssetsProcessCommand(Oct_Command *cmd);
+void _oct_AssetsProcessCommand(void *command);
 Oct_AssetType _oct_AssetType(Oct_Asset asset);
 int _oct_AssetGeneration(Oct_Asset asset);
 const char *_oct_AssetTypeString(Oct_Asset asset);
@@ -72,6 +108,8 @@ const char *_oct_AssetName(Oct_Asset asset);
 Oct_AssetData *_oct_AssetGet(Oct_Asset asset);
 Oct_AssetData *_oct_AssetGetSafe(Oct_Asset asset, Oct_AssetType type); // returns null if the type is wrong, generation is wrong, or the asset isn't loaded yet
 Oct_Asset _oct_AssetReserveSpace(); // used from logic thread to reserve a space in the asset list
+void _oct_AssetReserveSpecific(Oct_Asset asset); // used by replays to reserve the same space the captured game did
+Oct_AssetBundle _oct_CreateAssetBundle(); // Allocates an empty asset bundle
 void _oct_PlaceAssetInBucket(Oct_AssetBundle bundle, Oct_Asset asset, const char *name); // name will be copied
 void _oct_AssetsEnd();
 
@@ -79,6 +117,15 @@ void _oct_AssetsEnd();
 void _oct_JobsInit();
 void _oct_JobsUpdate();
 void _oct_JobsEnd();
+double _oct_JobsGetAverageWakeLatency();
+double _oct_JobsGetParkedPercent();
+void _oct_JobsBeginFrame(); // Called from the logic thread at the start of each frame, including startup
+int32_t _oct_JobsGetThreadCount();
+int32_t _oct_JobsThreadSlot(); // Job thread index, the job thread count for the logic thread, or -1 for other threads
+Oct_Bool _oct_JobsInJob(); // True if the calling thread is running a job or a range of an oct_ParallelFor
+struct Oct_DrawSortKey_t;
+struct Oct_DrawSortKey_t *_oct_JobsDrawSortKey(); // Sort key of whatever the calling thread is running, null outside of jobs
+int32_t _oct_JobsGetScratchHighWater(int32_t thread); // thread is a job thread index or the job thread count for the logic thread
 
 // Handles input processing on the logical thread
 void _oct_InputInit();
@@ -1,23 +1,208 @@
+#ifdef _WIN32
+# include <windows.h>
+#else
+# ifdef __linux__
+#  define _GNU_SOURCE // for MAP_NORESERVE and madvise
+# endif
+# include <sys/mman.h>
+#endif
+#include <string.h>
 #include <mimalloc.h>
+#include "oct/Validation.h"
 #include "oct/Opaque.h"
 #include "oct/Allocators.h"
 #include "oct/Constants.h"
 
-// Returns null if it fails, a new arena allocator otherwise
-static Oct_Allocator _oct_AddExtraPage(Oct_Allocator allocator, int32_t size) {
-    void *new = mi_realloc(
-            allocator->virtualPageAllocator.pages,
-            sizeof(Oct_Allocator) * (allocator->virtualPageAllocator.count + 1));
-    if (!new)
+/*
+ * A virtual page allocator only ever allocates from its current page. When that page is full it moves on to the next
+ * page, which is always empty, and only makes a new page if the next one is too small for the allocation (the new
+ * page is swapped into the next slot and the small one pushed to the back). Resetting only has to empty the pages up
+ * to the current one and the pages get reused in the same order, so a frame that allocates the same way as the last
+ * one never makes a new page and every allocation is O(1).
+ */
+
+// Moves the cursor to a page with at least size bytes free, returns null if it fails
+static Oct_Allocator _oct_NextPage(Oct_Allocator allocator, int32_t size) {
+    const int32_t next = allocator->virtualPageAllocator.count == 0 ? 0 : allocator->virtualPageAllocator.current + 1;
+    if (next < allocator->virtualPageAllocator.count && allocator->virtualPageAllocator.pages[next]->arenaAllocator.size >= size) {
+        allocator->virtualPageAllocator.current = next;
+        return allocator->virtualPageAllocator.pages[next];
+    }
+
+    // There are no pages with room, make a new one
+    if (allocator->virtualPageAllocator.count == allocator->virtualPageAllocator.capacity) {
+        const int32_t capacity = allocator->virtualPageAllocator.capacity == 0 ? 8 : allocator->virtualPageAllocator.capacity * 2;
+        void *new = mi_realloc(allocator->virtualPageAllocator.pages, sizeof(Oct_Allocator) * capacity);
+        if (!new)
+            return null;
+        allocator->virtualPageAllocator.pages = new;
+        allocator->virtualPageAllocator.capacity = capacity;
+    }
+    Oct_Allocator page = oct_CreateArenaAllocator(size < OCT_STANDARD_PAGE_SIZE ? OCT_STANDARD_PAGE_SIZE : size * OCT_PAGE_SCALE_FACTOR);
+    if (!page)
         return null;
-    allocator->virtualPageAllocator.pages = new;
-    allocator->virtualPageAllocator.pages[allocator->virtualPageAllocator.count] = oct_CreateArenaAllocator(size);
+    Oct_Allocator *pages = allocator->virtualPageAllocator.pages;
+    pages[allocator->virtualPageAllocator.count] = page;
+    if (next < allocator->virtualPageAllocator.count) {
+        pages[allocator->virtualPageAllocator.count] = pages[next];
+        pages[next] = page;
+    }
     allocator->virtualPageAllocator.count += 1;
-    return allocator->virtualPageAllocator.pages[allocator->virtualPageAllocator.count - 1];
+    allocator->virtualPageAllocator.current = next;
+    return page;
+}
+
+/*
+ * A pool keeps its free elements in intrusive singly linked lists, the first bytes of a free element point to the
+ * next one. The allocating thread pops from freeList without any synchronization. Frees can come from any thread so
+ * they're pushed onto remoteFree with a CAS, and when freeList runs dry the allocating thread takes the whole
+ * remoteFree list at once with an exchange. Since remoteFree is only ever pushed to or emptied all at once, never
+ * popped one at a time, there is no ABA problem. If both lists are empty the pool grows by another block.
+ */
+
+// Adds a block of free elements to a pool, returns false if it fails
+static Oct_Bool _oct_PoolGrow(Oct_Allocator allocator) {
+    if (allocator->poolAllocator.blockCount == allocator->poolAllocator.blockCapacity) {
+        const int32_t capacity = allocator->poolAllocator.blockCapacity == 0 ? 8 : allocator->poolAllocator.blockCapacity * 2;
+        void *new = mi_realloc(allocator->poolAllocator.blocks, sizeof(uint8_t*) * capacity);
+        if (!new)
+            return false;
+        allocator->poolAllocator.blocks = new;
+        allocator->poolAllocator.blockCapacity = capacity;
+    }
+    uint8_t *block = mi_malloc_aligned((size_t)allocator->poolAllocator.elementSize * allocator->poolAllocator.elementsPerBlock, OCT_ALLOCATION_ALIGNMENT);
+    if (!block)
+        return false;
+    allocator->poolAllocator.blocks[allocator->poolAllocator.blockCount++] = block;
+
+    // Thread the block onto the front of the free list
+    for (int32_t i = allocator->poolAllocator.elementsPerBlock - 1; i >= 0; i--) {
+        void **element = (void*)(block + (size_t)i * allocator->poolAllocator.elementSize);
+        *element = allocator->poolAllocator.freeList;
+        allocator->poolAllocator.freeList = element;
+    }
+    return true;
+}
+
+static void *_oct_PoolMalloc(Oct_Allocator allocator, int32_t size, int32_t align) {
+    if (size > allocator->poolAllocator.elementSize || align > OCT_ALLOCATION_ALIGNMENT)
+        return null;
+    if (!allocator->poolAllocator.freeList)
+        allocator->poolAllocator.freeList = SDL_SetAtomicPointer(&allocator->poolAllocator.remoteFree, null);
+    if (!allocator->poolAllocator.freeList && !_oct_PoolGrow(allocator))
+        return null;
+    void **element = allocator->poolAllocator.freeList;
+    allocator->poolAllocator.freeList = *element;
+    const int64_t used = SDL_AddAtomicInt(&allocator->poolAllocator.used, 1) + 1;
+    if (used * allocator->poolAllocator.elementSize > allocator->peakBytes)
+        allocator->peakBytes = used * allocator->poolAllocator.elementSize;
+    return element;
+}
+
+static void _oct_PoolFree(Oct_Allocator allocator, void *memory) {
+    void **element = memory;
+    void *head;
+    do {
+        head = SDL_GetAtomicPointer(&allocator->poolAllocator.remoteFree);
+        *element = head;
+    } while (!SDL_CompareAndSwapAtomicPointer(&allocator->poolAllocator.remoteFree, head, element));
+    SDL_AddAtomicInt(&allocator->poolAllocator.used, -1);
+}
+
+/*
+ * A virtual arena reserves a big range of address space up front and only commits memory to it as point moves
+ * forward, so it can keep growing in place without ever copying and without the gaps a virtual page allocator leaves
+ * at the end of each page. Memory is committed in chunks that double in size (at least VIRTUAL_ARENA_COMMIT_SIZE) so
+ * a growing arena doesn't make a syscall for every allocation. On reset anything committed past the furthest the
+ * arena got since the last reset is given back to the OS, so an arena that had one huge frame shrinks back down to
+ * what it actually uses.
+ */
+#define VIRTUAL_ARENA_COMMIT_SIZE (64 * 1024)
+
+// Commits memory so the arena has at least size bytes committed, returns false if it can't
+static Oct_Bool _oct_ArenaCommit(Oct_Allocator allocator, int64_t size) {
+    if (allocator->arenaAllocator.reserved == 0 || size > allocator->arenaAllocator.reserved)
+        return false;
+    int64_t committed = allocator->arenaAllocator.size * 2;
+    if (committed < size)
+        committed = size;
+    committed = (committed + VIRTUAL_ARENA_COMMIT_SIZE - 1) & ~((int64_t)VIRTUAL_ARENA_COMMIT_SIZE - 1);
+    if (committed > allocator->arenaAllocator.reserved)
+        committed = allocator->arenaAllocator.reserved;
+
+    uint8_t *start = allocator->arenaAllocator.buffer + allocator->arenaAllocator.size;
+    const size_t length = committed - allocator->arenaAllocator.size;
+#ifdef _WIN32
+    if (!VirtualAlloc(start, length, MEM_COMMIT, PAGE_READWRITE))
+        return false;
+#else
+    if (mprotect(start, length, PROT_READ | PROT_WRITE) != 0)
+        return false;
+#endif
+    allocator->arenaAllocator.size = committed;
+    return true;
+}
+
+// Gives back committed memory past the high water mark
+static void _oct_ArenaDecommit(Oct_Allocator allocator) {
+    int64_t keep = (allocator->arenaAllocator.highWater + VIRTUAL_ARENA_COMMIT_SIZE - 1) & ~((int64_t)VIRTUAL_ARENA_COMMIT_SIZE - 1);
+    if (keep < VIRTUAL_ARENA_COMMIT_SIZE)
+        keep = VIRTUAL_ARENA_COMMIT_SIZE;
+    if (keep >= allocator->arenaAllocator.size)
+        return;
+
+    uint8_t *start = allocator->arenaAllocator.buffer + keep;
+    const size_t length = allocator->arenaAllocator.size - keep;
+#ifdef _WIN32
+    VirtualFree(start, length, MEM_DECOMMIT);
+#else
+    madvise(start, length, MADV_DONTNEED);
+    mprotect(start, length, PROT_NONE);
+#endif
+    allocator->arenaAllocator.size = keep;
+}
+
+// Adds to a heap's stats, frees can come from any thread so the counts are behind the heap's lock
+static void _oct_HeapAdjust(Oct_Allocator allocator, int64_t bytes, int64_t count) {
+    SDL_LockSpinlock(&allocator->heapLock);
+    allocator->heapBytes += bytes;
+    allocator->allocationCount += count;
+    if (allocator->heapBytes > allocator->peakBytes)
+        allocator->peakBytes = allocator->heapBytes;
+    SDL_UnlockSpinlock(&allocator->heapLock);
+}
+
+// Counts a heap allocation (or a failed one if memory is null) in the heap's stats
+static void *_oct_HeapCount(Oct_Allocator allocator, void *memory) {
+    if (memory)
+        _oct_HeapAdjust(allocator, (int64_t)mi_usable_size(memory), 1);
+    return memory;
+}
+
+// Bytes currently allocated out of an allocator
+static int64_t _oct_AllocatorBytes(Oct_Allocator allocator) {
+    if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP)
+        return allocator->heapBytes;
+    if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA)
+        return allocator->arenaAllocator.point;
+    if (allocator->type == OCT_ALLOCATOR_TYPE_POOL)
+        return (int64_t)SDL_GetAtomicInt(&allocator->poolAllocator.used) * allocator->poolAllocator.elementSize;
+    int64_t used = 0;
+    if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE)
+        for (int i = 0; i <= allocator->virtualPageAllocator.current && i < allocator->virtualPageAllocator.count; i++)
+            used += allocator->virtualPageAllocator.pages[i]->arenaAllocator.point;
+    return used;
+}
+
+// Arenas and virtual page allocators only ever grow between resets and rewinds so the peak is checked right before
+static void _oct_UpdatePeak(Oct_Allocator allocator) {
+    const int64_t used = _oct_AllocatorBytes(allocator);
+    if (used > allocator->peakBytes)
+        allocator->peakBytes = used;
 }
 
 OCTARINE_API Oct_Allocator oct_CreateHeapAllocator() {
-    Oct_Allocator gpa = mi_malloc(sizeof(struct Oct_Allocator_t));
+    Oct_Allocator gpa = mi_zalloc(sizeof(struct Oct_Allocator_t));
     if (gpa) {
         gpa->type = OCT_ALLOCATOR_TYPE_HEAP;
         gpa->heapAllocator = mi_heap_new();
@@ -26,13 +211,16 @@ OCTARINE_API Oct_Allocator oct_CreateHeapAllocator() {
 }
 
 OCTARINE_API Oct_Allocator oct_CreateArenaAllocator(int32_t size) {
-    Oct_Allocator arena = mi_malloc(sizeof(struct Oct_Allocator_t));
+    Oct_Allocator arena = mi_zalloc(sizeof(struct Oct_Allocator_t));
     if (arena) {
         arena->type = OCT_ALLOCATOR_TYPE_ARENA;
         arena->arenaAllocator.buffer = mi_malloc(size);
         if (arena->arenaAllocator.buffer) {
             arena->arenaAllocator.size = size;
             arena->arenaAllocator.point = 0;
+            arena->arenaAllocator.last = 0;
+            arena->arenaAllocator.reserved = 0;
+            arena->arenaAllocator.highWater = 0;
         } else {
             mi_free(arena);
             arena = null;
@@ -41,30 +229,150 @@ OCTARINE_API Oct_Allocator oct_CreateArenaAllocator(int32_t size) {
     return arena;
 }
 
+OCTARINE_API Oct_Allocator oct_CreateVirtualArenaAllocator(int64_t reserve) {
+    if (reserve <= 0)
+        reserve = OCT_DEFAULT_VIRTUAL_ARENA_RESERVE;
+    reserve = (reserve + VIRTUAL_ARENA_COMMIT_SIZE - 1) & ~((int64_t)VIRTUAL_ARENA_COMMIT_SIZE - 1);
+    Oct_Allocator arena = mi_zalloc(sizeof(struct Oct_Allocator_t));
+    if (!arena)
+        return null;
+    arena->type = OCT_ALLOCATOR_TYPE_ARENA;
+#ifdef _WIN32
+    arena->arenaAllocator.buffer = VirtualAlloc(null, reserve, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    arena->arenaAllocator.buffer = mmap(null, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arena->arenaAllocator.buffer == MAP_FAILED)
+        arena->arenaAllocator.buffer = null;
+#endif
+    if (!arena->arenaAllocator.buffer) {
+        mi_free(arena);
+        return null;
+    }
+    arena->arenaAllocator.reserved = reserve;
+    if (!_oct_ArenaCommit(arena, VIRTUAL_ARENA_COMMIT_SIZE)) {
+        oct_FreeAllocator(arena);
+        return null;
+    }
+    return arena;
+}
+
 OCTARINE_API Oct_Allocator oct_CreateVirtualPageAllocator() {
-    Oct_Allocator arena = mi_malloc(sizeof(struct Oct_Allocator_t));
+    Oct_Allocator arena = mi_zalloc(sizeof(struct Oct_Allocator_t));
     if (arena) {
         arena->type = OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE;
         arena->virtualPageAllocator.count = 0;
+        arena->virtualPageAllocator.capacity = 0;
+        arena->virtualPageAllocator.current = 0;
         arena->virtualPageAllocator.pages = null;
     }
     return arena;
 }
 
+OCTARINE_API Oct_Allocator oct_CreatePoolAllocator(int32_t elementSize, int32_t elementsPerBlock) {
+    if (elementSize <= 0 || elementsPerBlock <= 0) {
+        oct_Raise(OCT_STATUS_BAD_PARAMETER, false, "Invalid pool of %i elements of %i bytes.", elementsPerBlock, elementSize);
+        return null;
+    }
+    Oct_Allocator pool = mi_zalloc(sizeof(struct Oct_Allocator_t));
+    if (pool) {
+        pool->type = OCT_ALLOCATOR_TYPE_POOL;
+        const int32_t size = elementSize < (int32_t)sizeof(void*) ? (int32_t)sizeof(void*) : elementSize;
+        pool->poolAllocator.elementSize = (size + OCT_ALLOCATION_ALIGNMENT - 1) & ~(OCT_ALLOCATION_ALIGNMENT - 1);
+        pool->poolAllocator.elementsPerBlock = elementsPerBlock;
+        if (!_oct_PoolGrow(pool)) {
+            mi_free(pool);
+            pool = null;
+        }
+    }
+    return pool;
+}
+
+OCTARINE_API void oct_GetPoolOccupancy(Oct_Allocator allocator, int32_t *used, int32_t *capacity) {
+    if (allocator->type != OCT_ALLOCATOR_TYPE_POOL) {
+        *used = 0;
+        *capacity = 0;
+        return;
+    }
+    *used = SDL_GetAtomicInt(&allocator->poolAllocator.used);
+    *capacity = allocator->poolAllocator.blockCount * allocator->poolAllocator.elementsPerBlock;
+}
+
+int32_t _oct_AllocatorBytesUsed(Oct_Allocator allocator) {
+    return allocator->type == OCT_ALLOCATOR_TYPE_HEAP ? 0 : (int32_t)_oct_AllocatorBytes(allocator);
+}
+
+OCTARINE_API void oct_GetAllocatorStats(Oct_Allocator allocator, Oct_AllocatorStats *stats) {
+    if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP) {
+        SDL_LockSpinlock(&allocator->heapLock);
+        stats->bytesAllocated = allocator->heapBytes;
+        stats->peakBytesAllocated = allocator->peakBytes;
+        stats->allocationCount = (int32_t)allocator->allocationCount;
+        stats->bytesReserved = allocator->heapBytes;
+        stats->pageCount = 0;
+        SDL_UnlockSpinlock(&allocator->heapLock);
+        return;
+    }
+    _oct_UpdatePeak(allocator);
+    stats->bytesAllocated = _oct_AllocatorBytes(allocator);
+    stats->peakBytesAllocated = allocator->peakBytes;
+    stats->allocationCount = (int32_t)allocator->allocationCount;
+    if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA) {
+        stats->bytesReserved = allocator->arenaAllocator.size;
+        stats->pageCount = 1;
+    } else if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE) {
+        stats->bytesReserved = 0;
+        for (int i = 0; i < allocator->virtualPageAllocator.count; i++)
+            stats->bytesReserved += allocator->virtualPageAllocator.pages[i]->arenaAllocator.size;
+        stats->pageCount = allocator->virtualPageAllocator.count;
+    } else if (allocator->type == OCT_ALLOCATOR_TYPE_POOL) {
+        stats->bytesReserved = (int64_t)allocator->poolAllocator.blockCount * allocator->poolAllocator.elementsPerBlock * allocator->poolAllocator.elementSize;
+        stats->pageCount = allocator->poolAllocator.blockCount;
+        stats->allocationCount = SDL_GetAtomicInt(&allocator->poolAllocator.used);
+    }
+}
+
 OCTARINE_API Oct_AllocatorType oct_GetAllocatorType(Oct_Allocator allocator) {
     return allocator->type;
 }
 
 OCTARINE_API void oct_ResetAllocator(Oct_Allocator allocator) {
     if (allocator) {
+        _oct_UpdatePeak(allocator);
+        allocator->allocationCount = 0;
         if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP) {
             mi_heap_delete(allocator->heapAllocator);
             allocator->heapAllocator = mi_heap_new();
+            SDL_LockSpinlock(&allocator->heapLock);
+            allocator->heapBytes = 0;
+            allocator->allocationCount = 0;
+            SDL_UnlockSpinlock(&allocator->heapLock);
         } else if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA) {
+            if (allocator->arenaAllocator.reserved > 0) {
+                if (allocator->arenaAllocator.point > allocator->arenaAllocator.highWater)
+                    allocator->arenaAllocator.highWater = allocator->arenaAllocator.point;
+                _oct_ArenaDecommit(allocator);
+                allocator->arenaAllocator.highWater = 0;
+            }
             allocator->arenaAllocator.point = 0;
+            allocator->arenaAllocator.last = 0;
         } else if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE) {
-            for (int i = 0; i < allocator->virtualPageAllocator.count; i++)
+            // Pages past the current one were never touched
+            for (int i = 0; i <= allocator->virtualPageAllocator.current && i < allocator->virtualPageAllocator.count; i++)
                 oct_ResetAllocator(allocator->virtualPageAllocator.pages[i]);
+            allocator->virtualPageAllocator.current = 0;
+        } else if (allocator->type == OCT_ALLOCATOR_TYPE_POOL) {
+            // Rebuild the free list from scratch with every element
+            allocator->poolAllocator.freeList = null;
+            SDL_SetAtomicPointer(&allocator->poolAllocator.remoteFree, null);
+            SDL_SetAtomicInt(&allocator->poolAllocator.used, 0);
+            for (int32_t i = allocator->poolAllocator.blockCount - 1; i >= 0; i--) {
+                uint8_t *block = allocator->poolAllocator.blocks[i];
+                for (int32_t j = allocator->poolAllocator.elementsPerBlock - 1; j >= 0; j--) {
+                    void **element = (void*)(block + (size_t)j * allocator->poolAllocator.elementSize);
+                    *element = allocator->poolAllocator.freeList;
+                    allocator->poolAllocator.freeList = element;
+                }
+            }
         }
     }
 }
@@ -73,83 +381,190 @@ OCTARINE_API void oct_FreeAllocator(Oct_Allocator allocator) {
     if (allocator) {
         if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP) {
             mi_heap_destroy(allocator->heapAllocator);
+        } else if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA && allocator->arenaAllocator.reserved > 0) {
+#ifdef _WIN32
+            VirtualFree(allocator->arenaAllocator.buffer, 0, MEM_RELEASE);
+#else
+            munmap(allocator->arenaAllocator.buffer, allocator->arenaAllocator.reserved);
+#endif
         } else if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA) {
             mi_free(allocator->arenaAllocator.buffer);
         } else if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE) {
             for (int i = 0; i < allocator->virtualPageAllocator.count; i++)
                 oct_FreeAllocator(allocator->virtualPageAllocator.pages[i]);
             mi_free(allocator->virtualPageAllocator.pages);
+        } else if (allocator->type == OCT_ALLOCATOR_TYPE_POOL) {
+            for (int32_t i = 0; i < allocator->poolAllocator.blockCount; i++)
+                mi_free(allocator->poolAllocator.blocks[i]);
+            mi_free(allocator->poolAllocator.blocks);
         }
         mi_free(allocator);
     }
 }
 
-OCTARINE_API void *oct_Malloc(Oct_Allocator allocator, int32_t size) {
-    if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP) {
-        return mi_heap_malloc(allocator->heapAllocator, size);
-    } else if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA) {
-        if (allocator->arenaAllocator.point + size <= allocator->arenaAllocator.size) {
-            void *out = &allocator->arenaAllocator.buffer[allocator->arenaAllocator.point];
-            allocator->arenaAllocator.point += size;
-            return out;
-        }
-    } else if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE) {
-        // Find a page with enough room
-        void *mem = null;
-        for (int i = 0; i < allocator->virtualPageAllocator.count; i++) {
-            mem = oct_Malloc(allocator->virtualPageAllocator.pages[i], size);
-            if (mem)
-                return mem;
-        }
+// Bumps an arena's point forward to an aligned allocation, returns null if it doesn't fit
+static void *_oct_ArenaMalloc(Oct_Allocator allocator, int32_t size, int32_t align) {
+    const uintptr_t base = (uintptr_t)allocator->arenaAllocator.buffer;
+    const uintptr_t start = (base + allocator->arenaAllocator.point + align - 1) & ~((uintptr_t)align - 1);
+    if (start + size > base + allocator->arenaAllocator.size && !_oct_ArenaCommit(allocator, (int64_t)(start + size - base)))
+        return null;
+    allocator->arenaAllocator.last = (int64_t)(start - base);
+    allocator->arenaAllocator.point = (int64_t)(start + size - base);
+    return (void*)start;
+}
 
-        // There are no available pages
-        Oct_Allocator alloc = _oct_AddExtraPage(
-                allocator,
-                size < OCT_STANDARD_PAGE_SIZE ? OCT_STANDARD_PAGE_SIZE : size * OCT_PAGE_SCALE_FACTOR);
-        if (alloc)
-            return oct_Malloc(alloc, size);
+// Reallocates out of an arena, the last allocation grows or shrinks in place if it fits
+static void *_oct_ArenaRealloc(Oct_Allocator allocator, void *memory, int32_t size) {
+    uint8_t *buffer = allocator->arenaAllocator.buffer;
+    if ((uint8_t*)memory == buffer + allocator->arenaAllocator.last &&
+        (allocator->arenaAllocator.last + size <= allocator->arenaAllocator.size || _oct_ArenaCommit(allocator, allocator->arenaAllocator.last + size))) {
+        allocator->arenaAllocator.point = allocator->arenaAllocator.last + size;
+        return memory;
     }
+
+    // The old size isn't known, but the allocation can't go past point so copying up to there gets all of it
+    const int64_t available = buffer + allocator->arenaAllocator.point - (uint8_t*)memory;
+    void *out = _oct_ArenaMalloc(allocator, size, OCT_ALLOCATION_ALIGNMENT);
+    if (out)
+        memcpy(out, memory, size < available ? size : available);
+    return out;
+}
+
+// Allocates out of the current page of a virtual page allocator or the next page if it doesn't fit
+static void *_oct_VirtualPageMalloc(Oct_Allocator allocator, int32_t size, int32_t align) {
+    if (allocator->virtualPageAllocator.count > 0) {
+        void *mem = _oct_ArenaMalloc(allocator->virtualPageAllocator.pages[allocator->virtualPageAllocator.current], size, align);
+        if (mem)
+            return mem;
+    }
+
+    // The next page needs enough room to align the allocation no matter where its buffer starts
+    Oct_Allocator page = _oct_NextPage(allocator, size + align - 1);
+    if (page)
+        return _oct_ArenaMalloc(page, size, align);
     return null;
 }
 
-OCTARINE_API void *oct_Realloc(Oct_Allocator allocator, void *memory, int32_t size) {
+static void *_oct_VirtualPageRealloc(Oct_Allocator allocator, void *memory, int32_t size) {
+    // Grow in place if it's the last allocation on the current page
+    Oct_Allocator current = allocator->virtualPageAllocator.pages[allocator->virtualPageAllocator.current];
+    if ((uint8_t*)memory == current->arenaAllocator.buffer + current->arenaAllocator.last && current->arenaAllocator.last + size <= current->arenaAllocator.size) {
+        current->arenaAllocator.point = current->arenaAllocator.last + size;
+        return memory;
+    }
+
+    // Otherwise it gets moved, up to the end of what was allocated on its page is copied since the old size isn't known
+    int32_t available = 0;
+    for (int32_t i = 0; i <= allocator->virtualPageAllocator.current; i++) {
+        Oct_Allocator page = allocator->virtualPageAllocator.pages[i];
+        if ((uint8_t*)memory >= page->arenaAllocator.buffer && (uint8_t*)memory < page->arenaAllocator.buffer + page->arenaAllocator.point) {
+            available = (int32_t)(page->arenaAllocator.buffer + page->arenaAllocator.point - (uint8_t*)memory);
+            break;
+        }
+    }
+    void *out = _oct_VirtualPageMalloc(allocator, size, OCT_ALLOCATION_ALIGNMENT);
+    if (out)
+        memcpy(out, memory, size < available ? size : available);
+    return out;
+}
+
+OCTARINE_API void *oct_MallocAligned(Oct_Allocator allocator, int32_t size, int32_t align) {
+    if (align <= 0 || (align & (align - 1)) != 0) {
+        oct_Raise(OCT_STATUS_BAD_PARAMETER, false, "Alignment %i is not a power of 2.", align);
+        return null;
+    }
+    void *out = null;
     if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP)
-        return mi_heap_realloc(allocator->heapAllocator, memory, size);
-    return NULL;
+        return _oct_HeapCount(allocator, mi_heap_malloc_aligned(allocator->heapAllocator, size, align));
+    else if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA)
+        out = _oct_ArenaMalloc(allocator, size, align);
+    else if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE)
+        out = _oct_VirtualPageMalloc(allocator, size, align);
+    else if (allocator->type == OCT_ALLOCATOR_TYPE_POOL)
+        return _oct_PoolMalloc(allocator, size, align);
+    if (out)
+        allocator->allocationCount++;
+    return out;
 }
 
-OCTARINE_API void *oct_Zalloc(Oct_Allocator allocator, int32_t size) {
+OCTARINE_API void *oct_Malloc(Oct_Allocator allocator, int32_t size) {
+    if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP)
+        return _oct_HeapCount(allocator, mi_heap_malloc(allocator->heapAllocator, size));
+    return oct_MallocAligned(allocator, size, OCT_ALLOCATION_ALIGNMENT);
+}
+
+OCTARINE_API void *oct_Realloc(Oct_Allocator allocator, void *memory, int32_t size) {
     if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP) {
-        return mi_heap_zalloc(allocator->heapAllocator, size);
-    } else if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA) {
-        if (allocator->arenaAllocator.point + size <= allocator->arenaAllocator.size) {
-            uint8_t *out = &allocator->arenaAllocator.buffer[allocator->arenaAllocator.point];
-            allocator->arenaAllocator.point += size;
-            for (int i = 0; i < size; i++) {
-                out[i] = 0;
-            }
-            return out;
-        }
-    } else if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE) {
-        // Find a page with enough room
-        void *mem = null;
-        for (int i = 0; i < allocator->virtualPageAllocator.count; i++) {
-            mem = oct_Zalloc(allocator->virtualPageAllocator.pages[i], size);
-            if (mem)
-                return mem;
+        const int64_t oldSize = memory ? (int64_t)mi_usable_size(memory) : 0;
+        void *out = mi_heap_realloc(allocator->heapAllocator, memory, size);
+        if (out)
+            _oct_HeapAdjust(allocator, (int64_t)mi_usable_size(out) - oldSize, memory ? 0 : 1);
+        return out;
+    }
+    if (!memory)
+        return oct_Malloc(allocator, size);
+    if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA)
+        return _oct_ArenaRealloc(allocator, memory, size);
+    if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE)
+        return _oct_VirtualPageRealloc(allocator, memory, size);
+    if (allocator->type == OCT_ALLOCATOR_TYPE_POOL && size <= allocator->poolAllocator.elementSize)
+        return memory;
+    return NULL;
+}
+
+OCTARINE_API Oct_AllocatorMark oct_AllocatorMark(Oct_Allocator allocator) {
+    if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA)
+        return (Oct_AllocatorMark)allocator->arenaAllocator.point;
+    if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE && allocator->virtualPageAllocator.count > 0) {
+        const int32_t current = allocator->virtualPageAllocator.current;
+        return ((Oct_AllocatorMark)current << 32) | (uint32_t)allocator->virtualPageAllocator.pages[current]->arenaAllocator.point;
+    }
+    return 0;
+}
+
+OCTARINE_API void oct_AllocatorRewind(Oct_Allocator allocator, Oct_AllocatorMark mark) {
+    _oct_UpdatePeak(allocator);
+    const int32_t page = (int32_t)(mark >> 32);
+    const int32_t point = (int32_t)(mark & UINT32_MAX);
+    if (allocator->type == OCT_ALLOCATOR_TYPE_ARENA) {
+        // Arena marks are just the point
+        if ((int64_t)mark <= allocator->arenaAllocator.point) {
+            if (allocator->arenaAllocator.point > allocator->arenaAllocator.highWater)
+                allocator->arenaAllocator.highWater = allocator->arenaAllocator.point;
+            allocator->arenaAllocator.point = (int64_t)mark;
+            allocator->arenaAllocator.last = (int64_t)mark;
         }
+    } else if (allocator->type == OCT_ALLOCATOR_TYPE_VIRTUAL_PAGE && allocator->virtualPageAllocator.count > 0) {
+        if (page > allocator->virtualPageAllocator.current)
+            return;
 
-        // There are no available pages
-        Oct_Allocator alloc = _oct_AddExtraPage(
-                allocator,
-                size < OCT_STANDARD_PAGE_SIZE ? OCT_STANDARD_PAGE_SIZE : size * OCT_PAGE_SCALE_FACTOR);
-        if (alloc)
-            return oct_Zalloc(alloc, size);
+        // Pages never move once they're at or before the current one, so everything after the mark is emptied and
+        // the page the mark is in goes back to where it was
+        for (int32_t i = page + 1; i <= allocator->virtualPageAllocator.current; i++)
+            oct_ResetAllocator(allocator->virtualPageAllocator.pages[i]);
+        Oct_Allocator markPage = allocator->virtualPageAllocator.pages[page];
+        if (point <= markPage->arenaAllocator.point) {
+            markPage->arenaAllocator.point = point;
+            markPage->arenaAllocator.last = point;
+        }
+        allocator->virtualPageAllocator.current = page;
     }
-    return null;
 }
 
-OCTARINE_API void oct_Free(Oct_Allocator allocator, void *memory) {
+OCTARINE_API void *oct_Zalloc(Oct_Allocator allocator, int32_t size) {
     if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP)
+        return _oct_HeapCount(allocator, mi_heap_zalloc(allocator->heapAllocator, size));
+    void *out = oct_MallocAligned(allocator, size, OCT_ALLOCATION_ALIGNMENT);
+    if (out)
+        memset(out, 0, size);
+    return out;
+}
+
+OCTARINE_API void oct_Free(Oct_Allocator allocator, void *memory) {
+    if (allocator->type == OCT_ALLOCATOR_TYPE_HEAP && memory) {
+        _oct_HeapAdjust(allocator, -(int64_t)mi_usable_size(memory), -1);
         mi_free(memory); // not confident this works
+    }
+    else if (allocator->type == OCT_ALLOCATOR_TYPE_POOL && memory)
+        _oct_PoolFree(allocator, memory);
 }
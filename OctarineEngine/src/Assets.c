@@ -605,8 +605,8 @@ void _oct_AssetsInit() {
     oct_Log("Asset system initialized.");
 }
 
-void _oct_AssetsProcessCommand(Oct_Command *cmd) {
-    Oct_LoadCommand *load = &cmd->loadCommand;
+void _oct_AssetsProcessCommand(void *command) {
+    Oct_LoadCommand *load = command;
     if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_TEXTURE) {
         _oct_AssetCreateTexture(load);
     } else if (load->type == OCT_LOAD_COMMAND_TYPE_CREATE_SURFACE) {
@@ -703,6 +703,10 @@ Oct_Asset _oct_AssetReserveSpace() {
     }
 }
 
+void _oct_AssetReserveSpecific(Oct_Asset asset) {
+    SDL_SetAtomicInt(&gAssets[ASSET_INDEX(asset)].reserved, 1);
+}
+
 ///////////////////////////////// EXTERNAL /////////////////////////////////
 OCTARINE_API Oct_Bool oct_AssetLoaded(Oct_Asset asset) {
     const Oct_Bool loaded = SDL_GetAtomicInt(&gAssets[ASSET_INDEX(asset)].loaded);
@@ -132,6 +132,9 @@ static int _oct_MixerThread(void *data) {
     SDL_ResumeAudioDevice(audioDevice);
     oct_Log("Created audio device and thread using \"%s\"", SDL_GetAudioDeviceName(audioDevice));
 
+    // Pinned once SDL has made its own audio threads so they don't inherit the mixer's core
+    _oct_PinThread(OCT_THREAD_SLOT_AUDIO);
+
     // Amount of samples that would be played during 1 tick of this update thing
     const int32_t UPDATE_SAMPLES = ((AUDIO_FREQUENCY_HZ / AUDIO_REFRESH_RATE_HZ) + 1) * AUDIO_CHANNELS;
 
@@ -211,11 +214,11 @@ void _oct_PlaySoundInternal(Oct_Audio id) {
     }
 }
 
-void _oct_AudioProcessCommand(Oct_Command *cmd) {
-    if (OCT_STRUCTURE_TYPE(&cmd->topOfUnion) == OCT_STRUCTURE_TYPE_META_COMMAND) {
+void _oct_AudioProcessCommand(void *command) {
+    if (OCT_STRUCTURE_TYPE(command) == OCT_STRUCTURE_TYPE_META_COMMAND) {
         // Meta commands currently do not impact the audio subsystem
     } else {
-        Oct_AudioCommand *audio = &cmd->audioCommand;
+        Oct_AudioCommand *audio = command;
         if (audio->type == OCT_AUDIO_COMMAND_TYPE_PLAY_SOUND) {
             int32_t index = SOUND_INDEX(audio->Play._soundID);
             if (index < MAX_PLAYING_SOUNDS && index != OCT_SOUND_FAILED) {
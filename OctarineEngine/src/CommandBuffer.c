@@ -1,3 +1,5 @@
+#include <stddef.h>
+#include <stdlib.h>
 #include <mimalloc.h>
 #include "oct/Validation.h"
 #include "oct/CommandBuffer.h"
@@ -6,38 +8,460 @@
 #include "oct/Subsystems.h"
 #include "oct/Allocators.h"
 
-// Quadruple buffer command buffer allocators so the logic thread is never writing to a buffer the render thread
-// is reading from
-Oct_Allocator gCommandBufferAllocators[4];
-int gCommandBufferAllocatorCurrent;
+/*
+ * Frame memory is quadruple buffered so the logic thread is never writing to a buffer the render thread is reading
+ * from. Every job thread and the logic thread have their own set of four allocators so frame memory can be used from
+ * jobs without any locking, any other thread shares one last set behind a spinlock. At the start of each frame the
+ * logic thread resets the next buffer in every set before it publishes the new index, so nothing can be allocating
+ * from a buffer while it's being reset.
+ */
+typedef struct FrameAllocators_t {
+    Oct_Allocator allocators[4];
+} FrameAllocators;
 
-// Wraps an index, returns index + 1 unless index == len - 1 in which case it returns 0
-static inline int32_t nextIndex(int32_t index, int32_t len) {
-    return index == len - 1 ? 0 : index + 1;
+static FrameAllocators *gFrameAllocators; // One per job thread, then the logic thread, then the shared set
+static int32_t gFrameAllocatorCount;
+static SDL_AtomicInt gFrameAllocatorCurrent;
+static SDL_SpinLock gSharedFrameAllocatorLock;
+
+// Frame memory statistics, taken from each frame's allocators as they're reset for reuse
+#define FRAME_MEMORY_HISTORY 120
+static SDL_SpinLock gFrameMemoryStatsLock;
+static Oct_AllocatorStats gFrameMemoryStats;             // Summed over every allocator of the last frame retired
+static float gFrameMemoryHistory[FRAME_MEMORY_HISTORY]; // Bytes each of the last few frames used
+static int32_t gFrameMemoryHistoryNext;
+
+/*
+ * Draws made from jobs don't go straight into the ring, they are recorded into a list owned by the thread running
+ * the job and merged into the frame at the end of the frame, sorted by the key of the job that made them (layer,
+ * index, submission, range, sequence, see Oct_DrawSortKey). The key belongs to the job rather than the thread, so
+ * the order draws reach the render thread doesn't depend on which thread happened to run which job. Threads without
+ * a slot (the render thread or the user's own threads helping out inside oct_WaitJob and friends) share one last
+ * list. The spinlock on each list is only ever contended by those threads or if a job is still drawing while the
+ * frame is being merged, which is a user error.
+ */
+typedef struct RecordedCommand_t {
+    Oct_DrawSortKey key;
+    Oct_DrawCommand draw;
+} RecordedCommand;
+
+typedef struct CommandList_t {
+    SDL_SpinLock lock;
+    RecordedCommand *commands;
+    int32_t count;
+    int32_t capacity;
+} CommandList;
+
+static CommandList *gCommandLists; // One per job thread, then the logic thread, then the shared list
+static int32_t gCommandListCount;
+static RecordedCommand *gMergeBuffer;
+static int32_t gMergeBufferCapacity;
+
+/*
+ * The command ring is a lock-free multi-producer single-consumer queue of variable-length records. Each record is an
+ * Oct_CommandHeader followed by only as much of the command as its type uses, so a sprite draw doesn't pay for the
+ * size of the biggest load command. Positions are byte offsets that only ever grow (and wrap as unsigned ints), the
+ * buffer index is the position masked by the capacity. A producer claims bytes by CAS'ing tail forward as long as
+ * that doesn't pass head by more than the capacity, writes the command straight into the ring, then sets the header's
+ * ready field to position + 1 to hand it to the render thread. A record never wraps around the end of the buffer,
+ * if it wouldn't fit the producer claims the rest of the buffer along with it and fills it with a padding record. The
+ * render thread processes records in place once they're ready and zeroes them before moving head past them so the
+ * next lap can't mistake old bytes for a finished record.
+ *
+ * oct_DrawBatch packs many draws into one record of type OCT_STRUCTURE_TYPE_DRAW_BATCH so a whole batch costs one
+ * CAS and one publish. The record is a DrawBatch followed by count draws, each only as big as its type needs rounded
+ * up to DRAW_BATCH_ALIGNMENT. Batches bigger than half the ring are split so a batch can never wait on itself.
+ */
+typedef struct DrawBatch_t {
+    int32_t count;   // Number of draws that follow
+    int32_t padding;
+} DrawBatch;
+#define DRAW_BATCH_ALIGNMENT 8
+
+// Statistics, only touched by the render thread besides the averages
+static uint64_t gStatsBytes;         // Bytes of records dispatched since the last roll up
+static uint64_t gStatsFixedBytes;    // Bytes those records would have taken as full Oct_Commands
+static uint64_t gStatsFrames;        // Frames dispatched since the last roll up
+static uint64_t gStatsStartTime;     // Last time the stats were rolled up
+static double gAverageBytesPerFrame;
+static double gAverageBytesSavedPerFrame;
+
+/*
+ * When the ring is full producers spin for a moment and then sleep on gFullCondition until the render thread frees
+ * up some space. Every stall also asks the render thread to double the ring, which it does the next time it finds the
+ * ring empty with no producer in the middle of writing (usually while the logic thread waits for its next frame). A
+ * producer counts itself in gWriters before touching the buffer and backs off while gResizing is set, and the render
+ * thread only swaps the buffer if gWriters is still 0 after setting gResizing, so neither can miss the other.
+ */
+#define FULL_SPIN_COUNT 100         // Pauses before a producer sleeps on a full ring
+#define MAX_RING_CAPACITY (1 << 28) // The ring won't grow past this many bytes
+static SDL_Mutex *gFullMutex;
+static SDL_Condition *gFullCondition;
+static SDL_AtomicInt gFullWaiters;   // Producers sleeping on gFullCondition
+static SDL_AtomicInt gWriters;       // Producers between beginCommand and endCommand
+static SDL_AtomicInt gResizing;      // Set while the render thread may be swapping the buffer
+static SDL_AtomicInt gGrowRequested; // Set by producers that stalled
+
+// Fill statistics, producers add to these and the render thread rolls them up once a second
+static SDL_AtomicInt gPeakOccupancy; // Most bytes in use at once since the last roll up
+static SDL_AtomicInt gStallCount;    // Number of times a producer found the ring full
+static SDL_AtomicInt gStallTime;     // Microseconds producers spent waiting on a full ring
+static SDL_AtomicInt gGrowCount;
+static SDL_SpinLock gFillStatsLock;
+static Oct_CommandBufferStats gFillStats;
+
+/*
+ * The render thread dispatches commands in lanes so one kind of command can't hold up the others. Draw and meta
+ * commands are always processed straight out of the ring so every draw lands in the frame it was sent in. Audio,
+ * window, and load commands are processed out of the ring too as long as their lane has nothing queued and time left
+ * in its budget for the frame, otherwise they're copied into the lane's queue to free up the ring. After the ring is
+ * drained each lane works through its queue until its budget runs out, and whatever is left waits for the next frame.
+ * A lane always gets through at least one command per frame so a command that takes longer than the whole budget
+ * can't get stuck. Queued commands can outlive the frame memory they point to, so what they point to is copied with
+ * them (besides file buffers, which belong to the user until their callback). Order is only kept within a lane, draws
+ * and sounds that need an asset with a queued load flush the load lane up to it (see gQueuedLoads).
+ */
+#define DEFAULT_LOAD_LANE_BUDGET 4000 // Microseconds
+
+typedef struct LaneRecord_t {
+    int32_t size;        // Bytes of the whole record, a multiple of OCT_COMMAND_ALIGNMENT
+    int32_t commandSize; // Bytes of command after this, the blob of what it points to follows the command
+    int32_t padding[2];
+} LaneRecord;
+
+typedef struct CommandLane_t {
+    uint8_t *records;      // Queued records, only touched by the render thread
+    int32_t start;         // Offset of the first queued record
+    int32_t end;           // Offset past the last queued record
+    int32_t capacity;
+    int32_t processed;     // Commands processed this frame
+    uint64_t spent;        // Performance counter ticks spent this frame
+    SDL_AtomicInt budget;  // Microseconds per frame, 0 for no limit
+    SDL_AtomicInt backlog; // Number of queued records
+} CommandLane;
+
+static CommandLane gLanes[OCT_COMMAND_LANE_MAX];
+
+/*
+ * Loads that get queued in the load lane are counted per asset so draws and sounds still come after the loads they
+ * were sent after. Before a draw or sound that uses an asset with a queued load is processed, the load lane is worked
+ * through (ignoring its budget) until that asset has no loads left in it. Only the render thread touches this.
+ */
+static int32_t gQueuedLoads[OCT_MAX_ASSETS];
+
+// Atomically reads an int and sets it to 0
+static int takeAtomicInt(SDL_AtomicInt *atomic) {
+    int value = SDL_GetAtomicInt(atomic);
+    while (!SDL_CompareAndSwapAtomicInt(atomic, value, 0))
+        value = SDL_GetAtomicInt(atomic);
+    return value;
+}
+
+// Size of a draw command that only has the part of the union its type uses
+int32_t _oct_DrawCommandSize(Oct_DrawCommandType type) {
+#define DRAW_SIZE(member) (int32_t)(offsetof(struct Oct_DrawCommand_t, member) + sizeof(((Oct_DrawCommand*)0)->member))
+    switch (type) {
+        case OCT_DRAW_COMMAND_TYPE_TEXTURE: return DRAW_SIZE(Texture);
+        case OCT_DRAW_COMMAND_TYPE_SHADER: return DRAW_SIZE(Shader);
+        case OCT_DRAW_COMMAND_TYPE_SPRITE: return DRAW_SIZE(Sprite);
+        case OCT_DRAW_COMMAND_TYPE_DEBUG_TEXT: return DRAW_SIZE(DebugText);
+        case OCT_DRAW_COMMAND_TYPE_RECTANGLE: return DRAW_SIZE(Rectangle);
+        case OCT_DRAW_COMMAND_TYPE_CIRCLE: return DRAW_SIZE(Circle);
+        case OCT_DRAW_COMMAND_TYPE_CAMERA: return DRAW_SIZE(Camera);
+        case OCT_DRAW_COMMAND_TYPE_TARGET: return DRAW_SIZE(Target);
+        case OCT_DRAW_COMMAND_TYPE_FONT_ATLAS: return DRAW_SIZE(FontAtlas);
+        default: return (int32_t)offsetof(struct Oct_DrawCommand_t, Rectangle);
+    }
+#undef DRAW_SIZE
+}
+
+// Size of a command in the ring, not counting the header
+static int32_t commandSize(void *command) {
+    const Oct_StructureType sType = OCT_STRUCTURE_TYPE(command);
+    if (sType == OCT_STRUCTURE_TYPE_DRAW_COMMAND)
+        return _oct_DrawCommandSize(((Oct_DrawCommand*)command)->type);
+    if (sType == OCT_STRUCTURE_TYPE_WINDOW_COMMAND)
+        return sizeof(struct Oct_WindowCommand_t);
+    if (sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND)
+        return sizeof(struct Oct_LoadCommand_t);
+    if (sType == OCT_STRUCTURE_TYPE_AUDIO_COMMAND)
+        return sizeof(struct Oct_AudioCommand_t);
+    return sizeof(struct Oct_MetaCommand_t);
+}
+
+// Sleeps until the render thread moves head past where it was or a little while passes
+static void waitForSpace(uint32_t head) {
+    Oct_Context ctx = _oct_GetCtx();
+    SDL_LockMutex(gFullMutex);
+    SDL_AddAtomicInt(&gFullWaiters, 1);
+    if ((uint32_t)SDL_GetAtomicInt(&ctx->RingBuffer.head) == head)
+        SDL_WaitConditionTimeout(gFullCondition, gFullMutex, 10);
+    SDL_AddAtomicInt(&gFullWaiters, -1);
+    SDL_UnlockMutex(gFullMutex);
+}
+
+// Claims space for a command in the ring at tail, stalling if its full, returns where to write the command to
+static void *beginCommand(Oct_StructureType sType, int32_t commandSize) {
+    Oct_Context ctx = _oct_GetCtx();
+    const uint32_t size = (sizeof(struct Oct_CommandHeader_t) + commandSize + OCT_COMMAND_ALIGNMENT - 1) & ~(OCT_COMMAND_ALIGNMENT - 1);
+
+    // Keep the render thread from swapping out the buffer while we use it
+    SDL_AddAtomicInt(&gWriters, 1);
+    while (SDL_GetAtomicInt(&gResizing)) {
+        SDL_AddAtomicInt(&gWriters, -1);
+        while (SDL_GetAtomicInt(&gResizing))
+            SDL_CPUPauseInstruction();
+        SDL_AddAtomicInt(&gWriters, 1);
+    }
+
+    const uint32_t capacity = ctx->RingBuffer.capacity;
+    uint32_t pos, head, padding;
+    uint64_t stallStart = 0;
+    int32_t spins = 0;
+    while (true) {
+        pos = SDL_GetAtomicInt(&ctx->RingBuffer.tail);
+        head = SDL_GetAtomicInt(&ctx->RingBuffer.head);
+        const uint32_t offset = pos & (capacity - 1);
+        padding = offset + size > capacity ? capacity - offset : 0;
+        if (pos + padding + size - head > capacity) {
+            // The buffer is full, wait for the render thread to catch up
+            if (stallStart == 0) {
+                stallStart = SDL_GetPerformanceCounter();
+                SDL_SetAtomicInt(&gGrowRequested, 1);
+            }
+            if (spins++ < FULL_SPIN_COUNT)
+                SDL_CPUPauseInstruction();
+            else
+                waitForSpace(head);
+        } else if (SDL_CompareAndSwapAtomicInt(&ctx->RingBuffer.tail, (int)pos, (int)(pos + padding + size))) {
+            break;
+        }
+    }
+
+    // Statistics
+    if (stallStart != 0) {
+        SDL_AddAtomicInt(&gStallCount, 1);
+        SDL_AddAtomicInt(&gStallTime, (int)(((SDL_GetPerformanceCounter() - stallStart) * 1000000) / SDL_GetPerformanceFrequency()));
+    }
+    const int occupancy = (int)(pos + padding + size - head);
+    int peak = SDL_GetAtomicInt(&gPeakOccupancy);
+    while (occupancy > peak && !SDL_CompareAndSwapAtomicInt(&gPeakOccupancy, peak, occupancy))
+        peak = SDL_GetAtomicInt(&gPeakOccupancy);
+
+    // Fill the end of the buffer with a record the render thread will skip
+    if (padding > 0) {
+        Oct_CommandHeader *pad = (void*)&ctx->RingBuffer.buffer[pos & (capacity - 1)];
+        pad->size = padding;
+        pad->sType = OCT_STRUCTURE_TYPE_NONE;
+        pad->position = pos;
+        SDL_SetAtomicInt(&pad->ready, (int)(pos + 1));
+        pos += padding;
+    }
+
+    Oct_CommandHeader *header = (void*)&ctx->RingBuffer.buffer[pos & (capacity - 1)];
+    header->size = size;
+    header->sType = sType;
+    header->position = pos;
+    return header + 1;
+}
+
+// Hands a command written after beginCommand to the render thread
+static inline void endCommand(void *command) {
+    Oct_CommandHeader *header = ((Oct_CommandHeader*)command) - 1;
+    SDL_SetAtomicInt(&header->ready, (int)(header->position + 1));
+    SDL_AddAtomicInt(&gWriters, -1);
 }
 
-// Places a command into the ring buffer at tail, stalling if its full
+// Copies a command into the ring buffer, only as many bytes as its type needs
 static inline void pushCommand(Oct_Command *command) {
+    const int32_t size = commandSize(&command->topOfUnion);
+    void *out = beginCommand(OCT_STRUCTURE_TYPE(&command->topOfUnion), size);
+    memcpy(out, &command->topOfUnion, size);
+    endCommand(out);
+}
+
+// Writes a draw directly into the ring buffer
+static inline void pushDraw(Oct_DrawCommand *draw) {
+    const int32_t size = _oct_DrawCommandSize(draw->type);
+    void *out = beginCommand(OCT_STRUCTURE_TYPE_DRAW_COMMAND, size);
+    memcpy(out, draw, size);
+    endCommand(out);
+}
+
+// Size of a draw inside of a batch record
+static inline int32_t batchedDrawSize(const Oct_DrawCommand *draw) {
+    return (_oct_DrawCommandSize(draw->type) + DRAW_BATCH_ALIGNMENT - 1) & ~(DRAW_BATCH_ALIGNMENT - 1);
+}
+
+// Writes as many draws as fit in half of the ring into a single batch record, returns how many were written, stride
+// is the distance in bytes between each draw so draws can be pulled out of bigger structs
+static int32_t pushDrawBatch(const Oct_DrawCommand *draws, size_t stride, int32_t count) {
+#define DRAW_AT(i) ((const Oct_DrawCommand*)((const uint8_t*)draws + (i) * stride))
     Oct_Context ctx = _oct_GetCtx();
+    const int32_t limit = ctx->RingBuffer.capacity / 2 - (int32_t)(sizeof(struct Oct_CommandHeader_t) + sizeof(struct DrawBatch_t));
+    int32_t size = 0;
+    int32_t batched = 0;
+    while (batched < count && size + batchedDrawSize(DRAW_AT(batched)) <= limit)
+        size += batchedDrawSize(DRAW_AT(batched++));
+
+    DrawBatch *batch = beginCommand(OCT_STRUCTURE_TYPE_DRAW_BATCH, sizeof(struct DrawBatch_t) + size);
+    batch->count = batched;
+    uint8_t *out = (void*)(batch + 1);
+    for (int32_t i = 0; i < batched; i++) {
+        memcpy(out, DRAW_AT(i), _oct_DrawCommandSize(DRAW_AT(i)->type));
+        ((Oct_DrawCommand*)out)->sType = OCT_STRUCTURE_TYPE_DRAW_COMMAND;
+        out += batchedDrawSize(DRAW_AT(i));
+    }
+    endCommand(batch);
+    return batched;
+#undef DRAW_AT
+}
+
+// Command list for draws made from a job on the calling thread
+static inline int32_t commandList() {
+    const int32_t thread = _oct_JobsThreadSlot();
+    return thread >= 0 ? thread : gCommandListCount - 1;
+}
+
+// Records draws made from a job into a thread's command list
+static void recordCommands(int32_t thread, const Oct_DrawCommand *draws, int32_t count) {
+    SDL_assert(thread >= 0 && thread < gCommandListCount);
+    CommandList *list = &gCommandLists[thread];
+    Oct_DrawSortKey *key = _oct_JobsDrawSortKey();
+    SDL_LockSpinlock(&list->lock);
+    if (list->count + count > list->capacity) {
+        int32_t capacity = list->capacity == 0 ? 256 : list->capacity * 2;
+        while (capacity < list->count + count)
+            capacity *= 2;
+        RecordedCommand *commands = mi_realloc(list->commands, sizeof(struct RecordedCommand_t) * capacity);
+        if (!commands)
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to grow command list to %i commands.", capacity);
+        list->commands = commands;
+        list->capacity = capacity;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        RecordedCommand *recorded = &list->commands[list->count++];
+        recorded->key = *key;
+        key->sequence++;
+        memcpy(&recorded->draw, &draws[i], _oct_DrawCommandSize(draws[i].type));
+        recorded->draw.sType = OCT_STRUCTURE_TYPE_DRAW_COMMAND;
+    }
+    SDL_UnlockSpinlock(&list->lock);
+}
+
+static int compareRecordedCommands(const void *a, const void *b) {
+    const Oct_DrawSortKey *x = &((const RecordedCommand*)a)->key;
+    const Oct_DrawSortKey *y = &((const RecordedCommand*)b)->key;
+    if (x->layer != y->layer)
+        return x->layer < y->layer ? -1 : 1;
+    if (x->index != y->index)
+        return x->index < y->index ? -1 : 1;
+    if (x->submission != y->submission)
+        return x->submission < y->submission ? -1 : 1;
+    if (x->range != y->range)
+        return x->range < y->range ? -1 : 1;
+    return x->sequence < y->sequence ? -1 : (x->sequence > y->sequence);
+}
 
-    SDL_LockMutex(ctx->RingBuffer.tailLock);
+// Sorts every thread's recorded commands into one list and pushes them into the ring
+static void mergeCommandLists() {
+    int32_t total = 0;
+    for (int i = 0; i < gCommandListCount; i++) {
+        SDL_LockSpinlock(&gCommandLists[i].lock);
+        total += gCommandLists[i].count;
+    }
 
-    // Busy loop if the buffer is full
-    int tail = SDL_GetAtomicInt(&ctx->RingBuffer.tail);
-    while (nextIndex(tail, ctx->initInfo->ringBufferSize) == SDL_GetAtomicInt(&ctx->RingBuffer.head)) {
-        volatile int i;
+    if (total > 0) {
+        if (total > gMergeBufferCapacity) {
+            RecordedCommand *buffer = mi_realloc(gMergeBuffer, sizeof(struct RecordedCommand_t) * total);
+            if (!buffer)
+                oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate merge buffer for %i commands.", total);
+            gMergeBuffer = buffer;
+            gMergeBufferCapacity = total;
+        }
+        int32_t count = 0;
+        for (int i = 0; i < gCommandListCount; i++) {
+            memcpy(&gMergeBuffer[count], gCommandLists[i].commands, sizeof(struct RecordedCommand_t) * gCommandLists[i].count);
+            count += gCommandLists[i].count;
+        }
     }
 
-    // Insert new element
-    memcpy(&ctx->RingBuffer.commands[tail], command, sizeof(struct Oct_Command_t));
-    SDL_SetAtomicInt(&ctx->RingBuffer.tail, nextIndex(tail, ctx->initInfo->ringBufferSize));
+    for (int i = 0; i < gCommandListCount; i++) {
+        gCommandLists[i].count = 0;
+        SDL_UnlockSpinlock(&gCommandLists[i].lock);
+    }
 
-    SDL_UnlockMutex(ctx->RingBuffer.tailLock);
+    if (total > 0) {
+        qsort(gMergeBuffer, total, sizeof(struct RecordedCommand_t), compareRecordedCommands);
+        for (int32_t i = 0; i < total;)
+            i += pushDrawBatch(&gMergeBuffer[i].draw, sizeof(struct RecordedCommand_t), total - i);
+    }
+}
+
+// Allocates from the calling thread's allocator for the current frame
+static void *frameMalloc(int32_t size) {
+    const int32_t current = SDL_GetAtomicInt(&gFrameAllocatorCurrent);
+    const int32_t thread = _oct_JobsThreadSlot();
+    void *mem;
+    if (thread >= 0) {
+        mem = oct_Malloc(gFrameAllocators[thread].allocators[current], size);
+    } else {
+        SDL_LockSpinlock(&gSharedFrameAllocatorLock);
+        mem = oct_Malloc(gFrameAllocators[gFrameAllocatorCount - 1].allocators[current], size);
+        SDL_UnlockSpinlock(&gSharedFrameAllocatorLock);
+    }
+    return mem;
+}
+
+// Adds a frame allocator's stats to the frame's total and resets it
+static void retireFrameAllocator(Oct_Allocator allocator, Oct_AllocatorStats *frame) {
+    Oct_AllocatorStats stats;
+    oct_GetAllocatorStats(allocator, &stats);
+    frame->bytesAllocated += stats.bytesAllocated;
+    frame->bytesReserved += stats.bytesReserved;
+    frame->pageCount += stats.pageCount;
+    frame->allocationCount += stats.allocationCount;
+    oct_ResetAllocator(allocator);
+}
+
+// Moves every thread on to the next frame's allocators, logic thread only
+static void cycleFrameMemory() {
+    // Nothing is allocating from the next buffer so it's safe to look at before it's reset
+    const int32_t next = (SDL_GetAtomicInt(&gFrameAllocatorCurrent) + 1) % 4;
+    Oct_AllocatorStats frame = {0};
+    for (int32_t i = 0; i < gFrameAllocatorCount - 1; i++)
+        retireFrameAllocator(gFrameAllocators[i].allocators[next], &frame);
+    SDL_LockSpinlock(&gSharedFrameAllocatorLock);
+    retireFrameAllocator(gFrameAllocators[gFrameAllocatorCount - 1].allocators[next], &frame);
+    SDL_UnlockSpinlock(&gSharedFrameAllocatorLock);
+    SDL_SetAtomicInt(&gFrameAllocatorCurrent, next);
+
+    SDL_LockSpinlock(&gFrameMemoryStatsLock);
+    frame.peakBytesAllocated = SDL_max(gFrameMemoryStats.peakBytesAllocated, frame.bytesAllocated);
+    gFrameMemoryStats = frame;
+    gFrameMemoryHistory[gFrameMemoryHistoryNext] = (float)frame.bytesAllocated;
+    gFrameMemoryHistoryNext = (gFrameMemoryHistoryNext + 1) % FRAME_MEMORY_HISTORY;
+    SDL_UnlockSpinlock(&gFrameMemoryStatsLock);
+}
+
+void _oct_CommandBufferGetFrameMemoryStats(Oct_AllocatorStats *stats) {
+    SDL_LockSpinlock(&gFrameMemoryStatsLock);
+    *stats = gFrameMemoryStats;
+    SDL_UnlockSpinlock(&gFrameMemoryStatsLock);
+}
+
+int32_t _oct_CommandBufferGetFrameMemoryHistory(float *history, int32_t count) {
+    count = SDL_min(count, FRAME_MEMORY_HISTORY);
+    SDL_LockSpinlock(&gFrameMemoryStatsLock);
+    for (int32_t i = 0; i < count; i++)
+        history[i] = gFrameMemoryHistory[(gFrameMemoryHistoryNext + FRAME_MEMORY_HISTORY - count + i) % FRAME_MEMORY_HISTORY];
+    SDL_UnlockSpinlock(&gFrameMemoryStatsLock);
+    return count;
 }
 
 // Allocates some memory into the command buffer allocator for the current frame, returns new memory location
 void *_oct_CopyIntoFrameMemory(void *data, int32_t size) {
-    void *mem = oct_Malloc(gCommandBufferAllocators[gCommandBufferAllocatorCurrent], size);
+    void *mem = frameMalloc(size);
     if (mem) {
         memcpy(mem, data, size);
         return mem;
@@ -48,7 +472,7 @@ void *_oct_CopyIntoFrameMemory(void *data, int32_t size) {
 }
 
 void *_oct_GetFrameMemory(int32_t size) {
-    void *mem = oct_Malloc(gCommandBufferAllocators[gCommandBufferAllocatorCurrent], size);
+    void *mem = frameMalloc(size);
     if (mem) {
         return mem;
     } else {
@@ -60,29 +484,53 @@ void *_oct_GetFrameMemory(int32_t size) {
 void _oct_CommandBufferInit() {
     Oct_Context ctx = _oct_GetCtx();
 
-    // Init ring buffer
-    ctx->RingBuffer.commands = mi_malloc(sizeof(struct Oct_Command_t) * OCT_RING_BUFFER_SIZE);
-    ctx->RingBuffer.tailLock = SDL_CreateMutex();
-    if (ctx->RingBuffer.commands && ctx->RingBuffer.tailLock) {
+    // Init ring buffer, it has room for at least ringBufferSize of the largest command and the capacity is rounded up
+    // to a power of 2 so positions can be masked
+    const int32_t bytes = ctx->initInfo->ringBufferSize * (int32_t)(sizeof(struct Oct_CommandHeader_t) + sizeof(struct Oct_Command_t));
+    int32_t capacity = OCT_COMMAND_ALIGNMENT;
+    while (capacity < bytes)
+        capacity *= 2;
+    ctx->RingBuffer.capacity = capacity;
+    ctx->RingBuffer.buffer = mi_zalloc_aligned(capacity, OCT_COMMAND_ALIGNMENT);
+    if (ctx->RingBuffer.buffer) {
         SDL_SetAtomicInt(&ctx->RingBuffer.head, 0);
         SDL_SetAtomicInt(&ctx->RingBuffer.tail, 0);
     } else {
-        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate ringbuffer or tail lock, SDL error %s.", SDL_GetError());
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate ringbuffer.");
     }
 
-    // Init memory quad buffer
-    for (int i = 0; i < 4; i++) {
-        gCommandBufferAllocators[i] = oct_CreateVirtualPageAllocator();
-        if (gCommandBufferAllocators[i] == null)
-            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to create command buffer allocator.");
+    // Backpressure
+    gFullMutex = SDL_CreateMutex();
+    gFullCondition = SDL_CreateCondition();
+    if (!gFullMutex || !gFullCondition)
+        oct_Raise(OCT_STATUS_SDL_ERROR, true, "Failed to create command buffer condition, SDL error %s", SDL_GetError());
+    gFillStats.capacity = capacity;
+    SDL_SetAtomicInt(&gLanes[OCT_COMMAND_LANE_LOAD].budget, DEFAULT_LOAD_LANE_BUDGET);
+
+    // Command lists for jobs
+    gCommandListCount = _oct_JobsGetThreadCount() + 2;
+    gCommandLists = mi_zalloc(sizeof(struct CommandList_t) * gCommandListCount);
+    if (!gCommandLists)
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate command lists.");
+
+    // Init memory quad buffers
+    gFrameAllocatorCount = _oct_JobsGetThreadCount() + 2;
+    gFrameAllocators = mi_zalloc(sizeof(struct FrameAllocators_t) * gFrameAllocatorCount);
+    if (!gFrameAllocators)
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate frame allocators.");
+    for (int32_t i = 0; i < gFrameAllocatorCount; i++) {
+        for (int j = 0; j < 4; j++) {
+            gFrameAllocators[i].allocators[j] = oct_CreateVirtualPageAllocator();
+            if (gFrameAllocators[i].allocators[j] == null)
+                oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to create command buffer allocator.");
+        }
     }
     oct_Log("Command buffer system initialized.");
 }
 
 void _oct_CommandBufferBeginFrame() {
-    // Cycle command buffer allocator
-    gCommandBufferAllocatorCurrent = (gCommandBufferAllocatorCurrent + 1) % 4;
-    oct_ResetAllocator(gCommandBufferAllocators[gCommandBufferAllocatorCurrent]);
+    // Cycle command buffer allocators
+    cycleFrameMemory();
 
     // Tell render thread that new frame is starting
     Oct_Command cmd = {
@@ -96,6 +544,8 @@ void _oct_CommandBufferBeginFrame() {
 }
 
 void _oct_CommandBufferEndFrame() {
+    mergeCommandLists();
+
     // Tell render thread that current frame is done
     Oct_Command cmd = {
             .sType = OCT_STRUCTURE_TYPE_COMMAND,
@@ -108,9 +558,8 @@ void _oct_CommandBufferEndFrame() {
 }
 
 void _oct_CommandBufferBeginSingleFrame() {
-    // Cycle command buffer allocator
-    gCommandBufferAllocatorCurrent = (gCommandBufferAllocatorCurrent + 1) % 4;
-    oct_ResetAllocator(gCommandBufferAllocators[gCommandBufferAllocatorCurrent]);
+    // Cycle command buffer allocators
+    cycleFrameMemory();
 
     // Tell render thread that new frame is starting
     Oct_Command cmd = {
@@ -124,6 +573,8 @@ void _oct_CommandBufferBeginSingleFrame() {
 }
 
 void _oct_CommandBufferEndSingleFrame() {
+    mergeCommandLists();
+
     // Tell render thread that current frame is done
     Oct_Command cmd = {
             .sType = OCT_STRUCTURE_TYPE_COMMAND,
@@ -135,33 +586,54 @@ void _oct_CommandBufferEndSingleFrame() {
     pushCommand(&cmd);
 }
 
-bool _oct_CommandBufferPop(Oct_Command *out) {
-    Oct_Context ctx = _oct_GetCtx();
-
-    if (SDL_GetAtomicInt(&ctx->RingBuffer.head) != SDL_GetAtomicInt(&ctx->RingBuffer.tail)) {
-        memcpy(out, &ctx->RingBuffer.commands[SDL_GetAtomicInt(&ctx->RingBuffer.head)], sizeof(struct Oct_Command_t));
-        SDL_SetAtomicInt(&ctx->RingBuffer.head, nextIndex(SDL_GetAtomicInt(&ctx->RingBuffer.head), ctx->initInfo->ringBufferSize));
-        return true;
-    }
-    return false;
-}
-
 void _oct_CommandBufferEnd() {
     Oct_Context ctx = _oct_GetCtx();
-    mi_free(ctx->RingBuffer.commands);
-    SDL_DestroyMutex(ctx->RingBuffer.tailLock);
-    for (int i = 0; i < 4; i++)
-        oct_FreeAllocator(gCommandBufferAllocators[i]);
+    mi_free(ctx->RingBuffer.buffer);
+    SDL_DestroyCondition(gFullCondition);
+    SDL_DestroyMutex(gFullMutex);
+    for (int i = 0; i < gCommandListCount; i++)
+        mi_free(gCommandLists[i].commands);
+    mi_free(gCommandLists);
+    mi_free(gMergeBuffer);
+    for (int32_t i = 0; i < gFrameAllocatorCount; i++)
+        for (int j = 0; j < 4; j++)
+            oct_FreeAllocator(gFrameAllocators[i].allocators[j]);
+    mi_free(gFrameAllocators);
+
+    // Anything still queued in a lane is dropped
+    for (int i = 0; i < OCT_COMMAND_LANE_MAX; i++)
+        mi_free(gLanes[i].records);
+    memset(gLanes, 0, sizeof(gLanes));
+    memset(gQueuedLoads, 0, sizeof(gQueuedLoads));
 }
 
 OCTARINE_API void oct_Draw(Oct_DrawCommand *draw) {
     draw->sType = OCT_STRUCTURE_TYPE_DRAW_COMMAND;
     draw->pNext = null;
-    Oct_Command cmd = {
-            .sType = OCT_STRUCTURE_TYPE_COMMAND,
-            .drawCommand = *draw
-    };
-    pushCommand(&cmd);
+    if (_oct_JobsInJob())
+        recordCommands(commandList(), draw, 1);
+    else
+        pushDraw(draw);
+}
+
+OCTARINE_API void oct_DrawBatch(const Oct_DrawCommand *draws, int32_t count) {
+    if (_oct_JobsInJob()) {
+        recordCommands(commandList(), draws, count);
+    } else {
+        while (count > 0) {
+            const int32_t batched = pushDrawBatch(draws, sizeof(struct Oct_DrawCommand_t), count);
+            draws += batched;
+            count -= batched;
+        }
+    }
+}
+
+OCTARINE_API void oct_SetDrawSortKey(int32_t layer, int32_t index) {
+    Oct_DrawSortKey *key = _oct_JobsDrawSortKey();
+    if (!key)
+        return;
+    key->layer = layer;
+    key->index = index;
 }
 
 OCTARINE_API void oct_WindowUpdate(Oct_WindowCommand *windowUpdate) {
@@ -374,35 +846,304 @@ OCTARINE_API void oct_FreeAsset(Oct_Asset asset) {
     pushCommand(&cmd);
 }
 
+// Doubles the ring if a producer stalled since the last time, only done while nobody is using the buffer
+static void growRing() {
+    Oct_Context ctx = _oct_GetCtx();
+    if (!SDL_GetAtomicInt(&gGrowRequested) || ctx->RingBuffer.capacity >= MAX_RING_CAPACITY)
+        return;
+
+    SDL_SetAtomicInt(&gResizing, 1);
+    if (SDL_GetAtomicInt(&gWriters) == 0 && SDL_GetAtomicInt(&ctx->RingBuffer.tail) == SDL_GetAtomicInt(&ctx->RingBuffer.head)) {
+        // Positions carry over as is, they're masked by the new capacity and the ring is empty
+        uint8_t *buffer = mi_zalloc_aligned(ctx->RingBuffer.capacity * 2, OCT_COMMAND_ALIGNMENT);
+        if (buffer) {
+            mi_free(ctx->RingBuffer.buffer);
+            ctx->RingBuffer.buffer = buffer;
+            ctx->RingBuffer.capacity *= 2;
+            SDL_AddAtomicInt(&gGrowCount, 1);
+            oct_Log("Command buffer grew to %.2fkb.", (double)ctx->RingBuffer.capacity / 1024);
+        } else {
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, false, "Failed to grow command buffer to %i bytes.", ctx->RingBuffer.capacity * 2);
+        }
+        SDL_SetAtomicInt(&gGrowRequested, 0);
+    }
+    SDL_SetAtomicInt(&gResizing, 0);
+}
+
+// Lane a command is dispatched in
+static Oct_CommandLane commandLane(Oct_StructureType sType) {
+    if (sType == OCT_STRUCTURE_TYPE_AUDIO_COMMAND)
+        return OCT_COMMAND_LANE_AUDIO;
+    if (sType == OCT_STRUCTURE_TYPE_WINDOW_COMMAND)
+        return OCT_COMMAND_LANE_WINDOW;
+    if (sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND)
+        return OCT_COMMAND_LANE_LOAD;
+    return OCT_COMMAND_LANE_DRAW;
+}
+
+// Number of loads queued for an asset, null if the asset can't have any
+static inline int32_t *queuedLoads(Oct_Asset asset) {
+    const uint32_t index = asset & INT32_MAX;
+    return asset != OCT_NO_ASSET && index < OCT_MAX_ASSETS ? &gQueuedLoads[index] : null;
+}
+
+// Counts a load command going into or coming out of the load lane
+static void countQueuedLoad(Oct_LoadCommand *load, int32_t delta) {
+    int32_t *count = queuedLoads(load->_assetID);
+    if (count)
+        *count += delta;
+    if (load->type == OCT_LOAD_COMMAND_TYPE_CREATE_FONT_ATLAS && (count = queuedLoads(load->FontAtlas.atlas)))
+        *count += delta;
+}
+
+static void processQueuedCommand(CommandLane *lane);
+
+// Processes queued loads until none are left for asset
+static void flushLoadsFor(Oct_Asset asset) {
+    CommandLane *lane = &gLanes[OCT_COMMAND_LANE_LOAD];
+    const int32_t *count = queuedLoads(asset);
+    while (count && *count > 0 && lane->start < lane->end)
+        processQueuedCommand(lane);
+}
+
+// Makes sure every asset a draw or audio command uses has gone through the load lane
+static void flushLoadsForCommand(void *command) {
+    if (gLanes[OCT_COMMAND_LANE_LOAD].start == gLanes[OCT_COMMAND_LANE_LOAD].end)
+        return;
+    const Oct_StructureType sType = OCT_STRUCTURE_TYPE(command);
+    if (sType == OCT_STRUCTURE_TYPE_AUDIO_COMMAND) {
+        Oct_AudioCommand *audio = command;
+        if (audio->type == OCT_AUDIO_COMMAND_TYPE_PLAY_SOUND)
+            flushLoadsFor(audio->Play.audio);
+        return;
+    }
+    if (sType != OCT_STRUCTURE_TYPE_DRAW_COMMAND)
+        return;
+    Oct_DrawCommand *draw = command;
+    switch (draw->type) {
+        case OCT_DRAW_COMMAND_TYPE_TEXTURE: flushLoadsFor(draw->Texture.texture); break;
+        case OCT_DRAW_COMMAND_TYPE_SHADER: flushLoadsFor(draw->Shader.shader); flushLoadsFor(draw->Shader.texture); break;
+        case OCT_DRAW_COMMAND_TYPE_SPRITE: flushLoadsFor(draw->Sprite.sprite); break;
+        case OCT_DRAW_COMMAND_TYPE_CAMERA: flushLoadsFor(draw->Camera.camera); break;
+        case OCT_DRAW_COMMAND_TYPE_TARGET: flushLoadsFor(draw->Target.texture); break;
+        case OCT_DRAW_COMMAND_TYPE_FONT_ATLAS: flushLoadsFor(draw->FontAtlas.atlas); break;
+        default: break;
+    }
+}
+
+static Oct_Bool laneHasTime(CommandLane *lane) {
+    const uint64_t budget = (uint64_t)SDL_GetAtomicInt(&lane->budget);
+    return budget == 0 || lane->processed == 0 || lane->spent < (budget * SDL_GetPerformanceFrequency()) / 1000000;
+}
+
+// Processes an audio, window, or load command and charges the time to its lane
+static void processLaneCommand(CommandLane *lane, void *command) {
+    // Loads a sound is waiting on are charged to the load lane
+    flushLoadsForCommand(command);
+    const uint64_t start = SDL_GetPerformanceCounter();
+    const Oct_StructureType sType = OCT_STRUCTURE_TYPE(command);
+    if (sType == OCT_STRUCTURE_TYPE_WINDOW_COMMAND)
+        _oct_WindowProcessCommand(command);
+    else if (sType == OCT_STRUCTURE_TYPE_AUDIO_COMMAND)
+        _oct_AudioProcessCommand(command);
+    else if (sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND)
+        _oct_AssetsProcessCommand(command);
+    lane->spent += SDL_GetPerformanceCounter() - start;
+    lane->processed++;
+}
+
+// Copies a command and everything it points to into the back of a lane's queue
+static void queueInLane(CommandLane *lane, void *command, int32_t size) {
+    Oct_Command copy;
+    void *out = &copy.topOfUnion;
+    memcpy(out, command, size);
+    void *blob;
+    const uint32_t blobSize = _oct_CommandPackPointers(out, false, &blob);
+    const int32_t recordSize = (sizeof(struct LaneRecord_t) + size + blobSize + OCT_COMMAND_ALIGNMENT - 1) & ~(OCT_COMMAND_ALIGNMENT - 1);
+
+    // Slide what's left to the front before growing
+    if (lane->end + recordSize > lane->capacity && lane->start > 0) {
+        memmove(lane->records, lane->records + lane->start, lane->end - lane->start);
+        lane->end -= lane->start;
+        lane->start = 0;
+    }
+    if (lane->end + recordSize > lane->capacity) {
+        int32_t capacity = lane->capacity == 0 ? 4096 : lane->capacity;
+        while (capacity < lane->end + recordSize)
+            capacity *= 2;
+        uint8_t *records = mi_realloc_aligned(lane->records, capacity, OCT_COMMAND_ALIGNMENT);
+        if (!records)
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to grow command lane to %i bytes.", capacity);
+        lane->records = records;
+        lane->capacity = capacity;
+    }
+
+    LaneRecord *record = (void*)(lane->records + lane->end);
+    record->size = recordSize;
+    record->commandSize = size;
+    memcpy(record + 1, out, size);
+    if (blobSize > 0)
+        memcpy((uint8_t*)(record + 1) + size, blob, blobSize);
+    lane->end += recordSize;
+    SDL_AddAtomicInt(&lane->backlog, 1);
+    if (OCT_STRUCTURE_TYPE(out) == OCT_STRUCTURE_TYPE_LOAD_COMMAND)
+        countQueuedLoad(out, 1);
+}
+
+// Processes the command at the front of a lane's queue, which must not be empty
+static void processQueuedCommand(CommandLane *lane) {
+    LaneRecord *record = (void*)(lane->records + lane->start);
+    void *command = record + 1;
+    _oct_CommandUnpackPointers(command, (uint8_t*)command + record->commandSize, false);
+    lane->start += record->size;
+    SDL_AddAtomicInt(&lane->backlog, -1);
+    if (OCT_STRUCTURE_TYPE(command) == OCT_STRUCTURE_TYPE_LOAD_COMMAND)
+        countQueuedLoad(command, -1);
+    processLaneCommand(lane, command);
+    if (lane->start == lane->end)
+        lane->start = lane->end = 0;
+}
+
+// Processes queued commands in a lane until its budget for the frame is spent
+static void drainLane(CommandLane *lane) {
+    while (lane->start < lane->end && laneHasTime(lane))
+        processQueuedCommand(lane);
+}
+
 void _oct_CommandBufferDispatch() {
-    Oct_Command cmd = {0};
-    while (_oct_CommandBufferPop(&cmd)) {
-        // Find out the kind of command this is
-        const Oct_StructureType sType = OCT_STRUCTURE_TYPE(&cmd.topOfUnion);
+    Oct_Context ctx = _oct_GetCtx();
+    const uint32_t mask = ctx->RingBuffer.capacity - 1;
+    const Oct_Bool process = !ctx->headless; // Headless engines go through the motions without any subsystems
 
-        // Dispatch to the proper subsystem
+    for (int i = 0; i < OCT_COMMAND_LANE_MAX; i++) {
+        gLanes[i].processed = 0;
+        gLanes[i].spent = 0;
+    }
+
+    // Only the render thread reads so head doesn't need to be claimed, a record is ready once its producer finished it
+    uint32_t head = SDL_GetAtomicInt(&ctx->RingBuffer.head);
+    while (true) {
+        Oct_CommandHeader *header = (void*)&ctx->RingBuffer.buffer[head & mask];
+        if ((uint32_t)SDL_GetAtomicInt(&header->ready) != head + 1)
+            break;
+        const int32_t size = header->size;
+        const Oct_StructureType sType = header->sType;
+        void *command = header + 1;
+        if (process && sType != OCT_STRUCTURE_TYPE_NONE && sType != OCT_STRUCTURE_TYPE_DRAW_BATCH)
+            _oct_CaptureCommand(command, commandSize(command));
+
+        // Dispatch to the proper subsystem, commands are processed right out of the ring
         if (sType == OCT_STRUCTURE_TYPE_META_COMMAND) {
             // Meta commands are dispatched everywhere
-            _oct_AudioProcessCommand(&cmd);
-            _oct_DrawingProcessCommand(&cmd);
-            _oct_WindowProcessCommand(&cmd);
+            if (process) {
+                _oct_AudioProcessCommand(command);
+                _oct_DrawingProcessCommand(command);
+                _oct_WindowProcessCommand(command);
+            }
+
+            const Oct_MetaCommandType type = ((Oct_MetaCommand*)command)->type;
+            if (type == OCT_META_COMMAND_TYPE_END_FRAME || type == OCT_META_COMMAND_TYPE_END_SINGLE_FRAME)
+                gStatsFrames++;
         } else if (sType == OCT_STRUCTURE_TYPE_DRAW_COMMAND) {
-            _oct_DrawingProcessCommand(&cmd);
-        } else if (sType == OCT_STRUCTURE_TYPE_WINDOW_COMMAND) {
-            _oct_WindowProcessCommand(&cmd);
-        } else if (sType == OCT_STRUCTURE_TYPE_AUDIO_COMMAND) {
-            _oct_AudioProcessCommand(&cmd);
-        } else if (sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND) {
-            _oct_AssetsProcessCommand(&cmd);
+            flushLoadsForCommand(command);
+            if (process)
+                _oct_DrawingProcessCommand(command);
+        } else if (sType == OCT_STRUCTURE_TYPE_DRAW_BATCH) {
+            DrawBatch *batch = command;
+            uint8_t *draw = (void*)(batch + 1);
+            for (int32_t i = 0; i < batch->count && process; i++) {
+                _oct_CaptureCommand(draw, _oct_DrawCommandSize(((Oct_DrawCommand*)draw)->type));
+                flushLoadsForCommand(draw);
+                _oct_DrawingProcessCommand(draw);
+                draw += batchedDrawSize((void*)draw);
+            }
+            gStatsFixedBytes += sizeof(struct Oct_Command_t) * (batch->count - 1);
+        } else if (process && (sType == OCT_STRUCTURE_TYPE_WINDOW_COMMAND || sType == OCT_STRUCTURE_TYPE_AUDIO_COMMAND || sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND)) {
+            // Lanes with a queue or no time left queue it behind what they already have
+            CommandLane *lane = &gLanes[commandLane(sType)];
+            if (lane->start == lane->end && laneHasTime(lane))
+                processLaneCommand(lane, command);
+            else
+                queueInLane(lane, command, commandSize(command));
+        }
+        if (sType != OCT_STRUCTURE_TYPE_NONE) {
+            gStatsBytes += size;
+            gStatsFixedBytes += sizeof(struct Oct_Command_t);
+        }
+
+        // Give the space back to the producers
+        memset(header, 0, size);
+        head += size;
+        SDL_SetAtomicInt(&ctx->RingBuffer.head, (int)head);
+        if (SDL_GetAtomicInt(&gFullWaiters) > 0) {
+            SDL_LockMutex(gFullMutex);
+            SDL_BroadcastCondition(gFullCondition);
+            SDL_UnlockMutex(gFullMutex);
         }
     }
+    for (int i = 0; i < OCT_COMMAND_LANE_MAX; i++)
+        drainLane(&gLanes[i]);
+    growRing();
+
+    // Roll up the stats every second
+    const uint64_t now = SDL_GetPerformanceCounter();
+    if (gStatsStartTime == 0) {
+        gStatsStartTime = now;
+    } else if (now - gStatsStartTime >= SDL_GetPerformanceFrequency()) {
+        const double frames = gStatsFrames > 0 ? gStatsFrames : 1;
+        if (gStatsFrames > 0) {
+            gAverageBytesPerFrame = (double)gStatsBytes / gStatsFrames;
+            gAverageBytesSavedPerFrame = (double)(gStatsFixedBytes - gStatsBytes) / gStatsFrames;
+        }
+        SDL_LockSpinlock(&gFillStatsLock);
+        gFillStats.capacity = ctx->RingBuffer.capacity;
+        gFillStats.peakOccupancy = takeAtomicInt(&gPeakOccupancy);
+        gFillStats.grows = SDL_GetAtomicInt(&gGrowCount);
+        gFillStats.stallsPerFrame = takeAtomicInt(&gStallCount) / frames;
+        gFillStats.stallTimePerFrame = (takeAtomicInt(&gStallTime) / 1000000.0) / frames;
+        SDL_UnlockSpinlock(&gFillStatsLock);
+        gStatsBytes = 0;
+        gStatsFixedBytes = 0;
+        gStatsFrames = 0;
+        gStatsStartTime = now;
+    }
+}
+
+OCTARINE_API void oct_SetCommandLaneBudget(Oct_CommandLane lane, double budget) {
+    if (lane < 0 || lane >= OCT_COMMAND_LANE_MAX) {
+        oct_Raise(OCT_STATUS_BAD_PARAMETER, false, "Invalid command lane %i.", lane);
+        return;
+    }
+    SDL_SetAtomicInt(&gLanes[lane].budget, budget > 0 ? (int)(budget * 1000000) : 0);
+}
+
+OCTARINE_API int32_t oct_GetCommandLaneBacklog(Oct_CommandLane lane) {
+    if (lane < 0 || lane >= OCT_COMMAND_LANE_MAX) {
+        oct_Raise(OCT_STATUS_BAD_PARAMETER, false, "Invalid command lane %i.", lane);
+        return 0;
+    }
+    return SDL_GetAtomicInt(&gLanes[lane].backlog);
+}
+
+OCTARINE_API void oct_GetCommandBufferStats(Oct_CommandBufferStats *stats) {
+    SDL_LockSpinlock(&gFillStatsLock);
+    *stats = gFillStats;
+    SDL_UnlockSpinlock(&gFillStatsLock);
+}
+
+double _oct_CommandBufferGetAverageBytesPerFrame() {
+    return gAverageBytesPerFrame;
+}
+
+double _oct_CommandBufferGetAverageBytesSavedPerFrame() {
+    return gAverageBytesSavedPerFrame;
 }
 
 OCTARINE_API void *oct_CopyFrameData(void *data, int32_t size) {
     return _oct_CopyIntoFrameMemory(data, size);
 }
 
-OCTARINE_API Oct_AssetBundle oct_LoadAssetBundle(const char *filename) {
+Oct_AssetBundle _oct_CreateAssetBundle() {
     Oct_AssetBundle bundle = mi_zalloc(sizeof(struct Oct_AssetBundle_t));
     if (!bundle)
         oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate asset bundle.");
@@ -413,6 +1154,11 @@ OCTARINE_API Oct_AssetBundle oct_LoadAssetBundle(const char *filename) {
         oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate asset bundle bucket.");
     for (int32_t i = 0; i < OCT_BUCKET_SIZE; i++)
         bundle->bucket[i].asset = OCT_NO_ASSET;
+    return bundle;
+}
+
+OCTARINE_API Oct_AssetBundle oct_LoadAssetBundle(const char *filename) {
+    Oct_AssetBundle bundle = _oct_CreateAssetBundle();
 
     Oct_Command cmd = {
             .sType = OCT_STRUCTURE_TYPE_COMMAND,
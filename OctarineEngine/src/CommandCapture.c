@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <string.h>
+#include <mimalloc.h>
+#include "oct/Validation.h"
+#include "oct/Opaque.h"
+#include "oct/Constants.h"
+#include "oct/Subsystems.h"
+#include "oct/Allocators.h"
+
+/*
+ * A capture is every command the render thread dispatched, in order, so the render side of a game can be replayed
+ * without its logic. The file starts with a CaptureHeader and then has one record per command: a CaptureRecord, the
+ * command itself (only as big as its type needs, same as the command ring), and a blob of everything the command
+ * points to. Pointers inside the command are rewritten as offset + 1 into the blob (0 is still null) so strings,
+ * shader uniforms, and file buffers from frame memory survive. Commands are written as raw structs, so a capture can
+ * only be replayed by a build with the same struct layout, the header records enough sizes to catch a mismatch.
+ */
+#define CAPTURE_MAGIC "OCTCAPT"
+#define CAPTURE_VERSION 1
+
+typedef struct CaptureHeader_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t pointerSize;
+    uint32_t drawCommandSize;
+    uint32_t loadCommandSize;
+    uint32_t audioCommandSize;
+    uint32_t windowCommandSize;
+} CaptureHeader;
+
+typedef struct CaptureRecord_t {
+    Oct_StructureType sType; // Type of the command that follows
+    uint32_t commandSize;    // Bytes of command that follow this record
+    uint32_t blobSize;       // Bytes of pointed-to data after the command
+    uint32_t padding;
+} CaptureRecord;
+
+// Capturing, only touched by the render thread
+static FILE *gCaptureFile;
+static Oct_Bool gWarnedUniformSize; // A shader draw missing its uniformSize has already been raised
+static uint8_t *gBlob;
+static uint32_t gBlobSize;
+static uint32_t gBlobCapacity;
+
+// Replaying, commands keep pointing into the frame they were read into until the drawing subsystem is done with
+// them so frames are quadruple buffered same as frame memory is
+static FILE *gReplayFile;
+static uint8_t *gReplayFrames[4];
+static uint32_t gReplayFrameCapacity[4];
+static int32_t gReplayFrameCurrent;
+static Oct_AssetBundle *gReplayBundles;
+static int32_t gReplayBundleCount;
+
+static void fillHeader(CaptureHeader *header) {
+    memset(header, 0, sizeof(struct CaptureHeader_t));
+    memcpy(header->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    header->version = CAPTURE_VERSION;
+    header->pointerSize = sizeof(void*);
+    header->drawCommandSize = sizeof(struct Oct_DrawCommand_t);
+    header->loadCommandSize = sizeof(struct Oct_LoadCommand_t);
+    header->audioCommandSize = sizeof(struct Oct_AudioCommand_t);
+    header->windowCommandSize = sizeof(struct Oct_WindowCommand_t);
+}
+
+///////////////////////////////// CAPTURE /////////////////////////////////
+
+// Copies data into the blob for the current command and returns what the pointer to it should be replaced with
+static void *addToBlob(const void *data, uint32_t size) {
+    if (!data)
+        return null;
+    if (gBlobSize + size > gBlobCapacity) {
+        uint32_t capacity = gBlobCapacity == 0 ? 1024 : gBlobCapacity;
+        while (capacity < gBlobSize + size)
+            capacity *= 2;
+        uint8_t *blob = mi_realloc(gBlob, capacity);
+        if (!blob)
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to grow command capture blob to %i bytes.", capacity);
+        gBlob = blob;
+        gBlobCapacity = capacity;
+    }
+    memcpy(gBlob + gBlobSize, data, size);
+    const uintptr_t offset = gBlobSize + 1;
+    gBlobSize += size;
+    return (void*)offset;
+}
+
+static const char *addStringToBlob(const char *string) {
+    return string ? addToBlob(string, strlen(string) + 1) : null;
+}
+
+// Packs a file handle's pointers into the blob, buffers only if copyBuffers is set
+static void packFileHandle(Oct_FileHandle *handle, Oct_Bool copyBuffers) {
+    if (handle->type == OCT_FILE_HANDLE_TYPE_FILENAME) {
+        handle->filename = addStringToBlob(handle->filename);
+    } else if (handle->type == OCT_FILE_HANDLE_TYPE_FILE_BUFFER) {
+        handle->name = addStringToBlob(handle->name);
+        if (copyBuffers) {
+            // The copy isn't the user's buffer anymore so there is nothing to hand back to the callback
+            handle->buffer = addToBlob(handle->buffer, handle->size);
+            handle->callback = null;
+        }
+    }
+}
+
+uint32_t _oct_CommandPackPointers(void *command, Oct_Bool copyBuffers, void **blob) {
+    gBlobSize = 0;
+    const Oct_StructureType sType = OCT_STRUCTURE_TYPE(command);
+    if (sType == OCT_STRUCTURE_TYPE_DRAW_COMMAND) {
+        Oct_DrawCommand *draw = command;
+        if (draw->type == OCT_DRAW_COMMAND_TYPE_DEBUG_TEXT) {
+            draw->DebugText.text = addStringToBlob(draw->DebugText.text);
+        } else if (draw->type == OCT_DRAW_COMMAND_TYPE_FONT_ATLAS) {
+            draw->FontAtlas.text = addStringToBlob(draw->FontAtlas.text);
+        } else if (draw->type == OCT_DRAW_COMMAND_TYPE_SHADER) {
+            draw->Shader.uniformData = draw->Shader.uniformSize > 0 ? addToBlob(draw->Shader.uniformData, draw->Shader.uniformSize) : null;
+        }
+    } else if (sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND) {
+        Oct_LoadCommand *load = command;
+        if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_TEXTURE) {
+            packFileHandle(&load->Texture.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_AUDIO) {
+            packFileHandle(&load->Audio.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_FONT) {
+            for (int i = 0; i < OCT_FALLBACK_FONT_MAX; i++)
+                packFileHandle(&load->Font.fileHandles[i], copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_BITMAP_FONT) {
+            packFileHandle(&load->BitmapFont.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_SHADER) {
+            packFileHandle(&load->Shader.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_ASSET_BUNDLE) {
+            load->AssetBundle.filename = addStringToBlob(load->AssetBundle.filename);
+        }
+    }
+    *blob = gBlob;
+    return gBlobSize;
+}
+
+void _oct_CaptureInit() {
+    Oct_Context ctx = _oct_GetCtx();
+    if (!ctx->initInfo->captureFile)
+        return;
+
+    gCaptureFile = fopen(ctx->initInfo->captureFile, "wb");
+    if (!gCaptureFile) {
+        oct_Raise(OCT_STATUS_FILE_DOES_NOT_EXIST, false, "Failed to open command capture file \"%s\".", ctx->initInfo->captureFile);
+        return;
+    }
+    CaptureHeader header;
+    fillHeader(&header);
+    fwrite(&header, sizeof(struct CaptureHeader_t), 1, gCaptureFile);
+    oct_Log("Capturing commands to \"%s\".", ctx->initInfo->captureFile);
+}
+
+void _oct_CaptureCommand(void *command, int32_t size) {
+    if (!gCaptureFile)
+        return;
+
+    // Work on a copy so the pointers can be rewritten, the bundle a bundle load goes into can't be captured
+    Oct_Command copy;
+    void *out = &copy.topOfUnion;
+    memcpy(out, command, size);
+    void *blob;
+    const uint32_t blobSize = _oct_CommandPackPointers(out, true, &blob);
+    const Oct_StructureType sType = OCT_STRUCTURE_TYPE(command);
+    if (sType == OCT_STRUCTURE_TYPE_DRAW_COMMAND && !gWarnedUniformSize) {
+        // Without a size the uniforms can't be copied, so the capture replays the shader without them
+        const Oct_DrawCommand *draw = command;
+        if (draw->type == OCT_DRAW_COMMAND_TYPE_SHADER && draw->Shader.uniformData && draw->Shader.uniformSize == 0) {
+            oct_Raise(OCT_STATUS_BAD_PARAMETER, false, "Shader draw has uniformData but no uniformSize, its uniforms won't be in the capture.");
+            gWarnedUniformSize = true;
+        }
+    }
+    if (sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND && ((Oct_LoadCommand*)out)->type == OCT_LOAD_COMMAND_TYPE_LOAD_ASSET_BUNDLE)
+        ((Oct_LoadCommand*)out)->AssetBundle.bundle = null;
+
+    CaptureRecord record = {
+            .sType = sType,
+            .commandSize = size,
+            .blobSize = blobSize
+    };
+    fwrite(&record, sizeof(struct CaptureRecord_t), 1, gCaptureFile);
+    fwrite(out, size, 1, gCaptureFile);
+    if (blobSize > 0)
+        fwrite(blob, blobSize, 1, gCaptureFile);
+}
+
+void _oct_CaptureEnd() {
+    if (gCaptureFile)
+        fclose(gCaptureFile);
+    gCaptureFile = null;
+    mi_free(gBlob);
+}
+
+///////////////////////////////// REPLAY /////////////////////////////////
+
+static void *fromBlob(uint8_t *blob, const void *pointer) {
+    return pointer ? blob + ((uintptr_t)pointer - 1) : null;
+}
+
+static void unpackFileHandle(uint8_t *blob, Oct_FileHandle *handle, Oct_Bool copyBuffers) {
+    if (handle->type == OCT_FILE_HANDLE_TYPE_FILENAME) {
+        handle->filename = fromBlob(blob, handle->filename);
+    } else if (handle->type == OCT_FILE_HANDLE_TYPE_FILE_BUFFER) {
+        handle->name = fromBlob(blob, handle->name);
+        if (copyBuffers)
+            handle->buffer = fromBlob(blob, handle->buffer);
+    }
+}
+
+void _oct_CommandUnpackPointers(void *command, void *blob, Oct_Bool copyBuffers) {
+    const Oct_StructureType sType = OCT_STRUCTURE_TYPE(command);
+    if (sType == OCT_STRUCTURE_TYPE_DRAW_COMMAND) {
+        Oct_DrawCommand *draw = command;
+        if (draw->type == OCT_DRAW_COMMAND_TYPE_DEBUG_TEXT)
+            draw->DebugText.text = fromBlob(blob, draw->DebugText.text);
+        else if (draw->type == OCT_DRAW_COMMAND_TYPE_FONT_ATLAS)
+            draw->FontAtlas.text = fromBlob(blob, draw->FontAtlas.text);
+        else if (draw->type == OCT_DRAW_COMMAND_TYPE_SHADER)
+            draw->Shader.uniformData = fromBlob(blob, draw->Shader.uniformData);
+    } else if (sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND) {
+        Oct_LoadCommand *load = command;
+        if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_TEXTURE) {
+            unpackFileHandle(blob, &load->Texture.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_AUDIO) {
+            unpackFileHandle(blob, &load->Audio.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_FONT) {
+            for (int i = 0; i < OCT_FALLBACK_FONT_MAX; i++)
+                unpackFileHandle(blob, &load->Font.fileHandles[i], copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_BITMAP_FONT) {
+            unpackFileHandle(blob, &load->BitmapFont.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_SHADER) {
+            unpackFileHandle(blob, &load->Shader.fileHandle, copyBuffers);
+        } else if (load->type == OCT_LOAD_COMMAND_TYPE_LOAD_ASSET_BUNDLE) {
+            load->AssetBundle.filename = fromBlob(blob, load->AssetBundle.filename);
+        }
+    }
+}
+
+// The bundle the game loaded into doesn't exist here, make a new one to load into
+static void replayBundle(Oct_LoadCommand *load) {
+    Oct_AssetBundle *bundles = mi_realloc(gReplayBundles, sizeof(Oct_AssetBundle) * (gReplayBundleCount + 1));
+    if (!bundles)
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate replay bundle list.");
+    gReplayBundles = bundles;
+    load->AssetBundle.bundle = gReplayBundles[gReplayBundleCount++] = _oct_CreateAssetBundle();
+}
+
+Oct_Bool _oct_ReplayOpen(const char *filename) {
+    gReplayFile = fopen(filename, "rb");
+    if (!gReplayFile) {
+        oct_Raise(OCT_STATUS_FILE_DOES_NOT_EXIST, false, "Failed to open command capture \"%s\".", filename);
+        return false;
+    }
+
+    CaptureHeader header, expected;
+    fillHeader(&expected);
+    if (fread(&header, sizeof(struct CaptureHeader_t), 1, gReplayFile) != 1 || memcmp(&header, &expected, sizeof(struct CaptureHeader_t)) != 0) {
+        oct_Raise(OCT_STATUS_BAD_PARAMETER, false, "\"%s\" is not a command capture from this version of Octarine.", filename);
+        fclose(gReplayFile);
+        gReplayFile = null;
+        return false;
+    }
+    oct_Log("Replaying commands from \"%s\".", filename);
+    return true;
+}
+
+Oct_Bool _oct_ReplayFrame() {
+    // Read every record up to and including the end of the next frame into the next frame buffer
+    gReplayFrameCurrent = (gReplayFrameCurrent + 1) % 4;
+    uint32_t size = 0;
+    Oct_Bool frameDone = false;
+    while (!frameDone) {
+        CaptureRecord record;
+        if (fread(&record, sizeof(struct CaptureRecord_t), 1, gReplayFile) != 1)
+            break;
+        const uint32_t recordSize = sizeof(struct CaptureRecord_t) + record.commandSize + record.blobSize;
+        if (size + recordSize > gReplayFrameCapacity[gReplayFrameCurrent]) {
+            uint32_t capacity = gReplayFrameCapacity[gReplayFrameCurrent] == 0 ? 4096 : gReplayFrameCapacity[gReplayFrameCurrent];
+            while (capacity < size + recordSize)
+                capacity *= 2;
+            uint8_t *frame = mi_realloc_aligned(gReplayFrames[gReplayFrameCurrent], capacity, OCT_COMMAND_ALIGNMENT);
+            if (!frame)
+                oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to grow replay frame to %i bytes.", capacity);
+            gReplayFrames[gReplayFrameCurrent] = frame;
+            gReplayFrameCapacity[gReplayFrameCurrent] = capacity;
+        }
+        uint8_t *out = gReplayFrames[gReplayFrameCurrent] + size;
+        memcpy(out, &record, sizeof(struct CaptureRecord_t));
+        if (fread(out + sizeof(struct CaptureRecord_t), record.commandSize + record.blobSize, 1, gReplayFile) != 1)
+            break;
+        size += recordSize;
+
+        if (record.sType == OCT_STRUCTURE_TYPE_META_COMMAND) {
+            const Oct_MetaCommandType type = ((Oct_MetaCommand*)(out + sizeof(struct CaptureRecord_t)))->type;
+            frameDone = type == OCT_META_COMMAND_TYPE_END_FRAME || type == OCT_META_COMMAND_TYPE_END_SINGLE_FRAME;
+        }
+
+        // Keep records aligned
+        size = (size + OCT_COMMAND_ALIGNMENT - 1) & ~(OCT_COMMAND_ALIGNMENT - 1);
+    }
+    if (!frameDone)
+        return false;
+
+    // Reserve every asset the frame loads before anything runs, the logic thread reserved them before it sent the
+    // frame so assets that reserve more on the render thread (bundles) mustn't take them
+    for (uint32_t i = 0; i < size;) {
+        CaptureRecord *record = (void*)(gReplayFrames[gReplayFrameCurrent] + i);
+        Oct_LoadCommand *load = (void*)(record + 1);
+        if (record->sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND && load->type != OCT_LOAD_COMMAND_TYPE_FREE && load->_assetID != OCT_NO_ASSET)
+            _oct_AssetReserveSpecific(load->_assetID);
+        i += (sizeof(struct CaptureRecord_t) + record->commandSize + record->blobSize + OCT_COMMAND_ALIGNMENT - 1) & ~(OCT_COMMAND_ALIGNMENT - 1);
+    }
+
+    // Process the frame the same way _oct_CommandBufferDispatch would, window commands are skipped so a replay can't
+    // resize or fullscreen the window
+    for (uint32_t i = 0; i < size;) {
+        CaptureRecord *record = (void*)(gReplayFrames[gReplayFrameCurrent] + i);
+        void *command = record + 1;
+        _oct_CommandUnpackPointers(command, (uint8_t*)command + record->commandSize, true);
+        if (record->sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND && ((Oct_LoadCommand*)command)->type == OCT_LOAD_COMMAND_TYPE_LOAD_ASSET_BUNDLE)
+            replayBundle(command);
+        if (record->sType == OCT_STRUCTURE_TYPE_META_COMMAND) {
+            _oct_AudioProcessCommand(command);
+            _oct_DrawingProcessCommand(command);
+            _oct_WindowProcessCommand(command);
+        } else if (record->sType == OCT_STRUCTURE_TYPE_DRAW_COMMAND) {
+            _oct_DrawingProcessCommand(command);
+        } else if (record->sType == OCT_STRUCTURE_TYPE_AUDIO_COMMAND) {
+            _oct_AudioProcessCommand(command);
+        } else if (record->sType == OCT_STRUCTURE_TYPE_LOAD_COMMAND) {
+            _oct_AssetsProcessCommand(command);
+        }
+        i += (sizeof(struct CaptureRecord_t) + record->commandSize + record->blobSize + OCT_COMMAND_ALIGNMENT - 1) & ~(OCT_COMMAND_ALIGNMENT - 1);
+    }
+    return true;
+}
+
+void _oct_ReplayClose() {
+    if (gReplayFile)
+        fclose(gReplayFile);
+    gReplayFile = null;
+    for (int i = 0; i < 4; i++)
+        mi_free(gReplayFrames[i]);
+
+    // Assets in the bundles are cleaned up with the rest of the asset system, only the bundles themselves are freed
+    for (int32_t i = 0; i < gReplayBundleCount; i++) {
+        Oct_AssetBundle bundle = gReplayBundles[i];
+        for (int j = 0; j < OCT_BUCKET_SIZE; j++)
+            if (bundle->bucket[j].asset != OCT_NO_ASSET)
+                mi_free((void*)bundle->bucket[j].name);
+        for (int j = 0; j < bundle->backupBucketCount; j++)
+            if (bundle->backupBucket[j].asset != OCT_NO_ASSET)
+                mi_free((void*)bundle->backupBucket[j].name);
+        mi_free(bundle->bucket);
+        mi_free(bundle->backupBucket);
+        mi_free(bundle);
+    }
+    mi_free(gReplayBundles);
+}
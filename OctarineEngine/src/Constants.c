@@ -25,4 +25,5 @@ int32_t OCT_SPRITE_FIRST_FRAME = 0;
 Oct_Asset OCT_TARGET_SWAPCHAIN = UINT64_MAX;
 Oct_Asset OCT_NO_ASSET = UINT64_MAX;
 Oct_Sound OCT_SOUND_FAILED = UINT64_MAX;
-int32_t OCT_MINIMUM_JOB_THREADS = 10;
+Oct_Job OCT_NO_JOB = UINT64_MAX;
+int32_t OCT_MINIMUM_JOB_THREADS = 2;
@@ -1,3 +1,8 @@
+#ifdef __linux__
+# define _GNU_SOURCE // for sched_setaffinity
+# include <sched.h>
+#endif
+#include <stdlib.h>
 #include <VK2D/VK2D.h>
 #include <mimalloc.h>
 #include <physfs.h>
@@ -38,10 +43,10 @@ size_t memory_used(bool resident) {
     size_t size = 0;
     FILE *file = fopen("/proc/self/statm", "r");
     if (file) {
-        unsigned long vm = 0;
-        fscanf (file, "%ul", &vm);  // Just need the first num: vm size
+        unsigned long vm = 0, rss = 0;
+        fscanf (file, "%lu %lu", &vm, &rss);  // vm size then resident set size
         fclose (file);
-       size = (size_t)vm * getpagesize();
+       size = (size_t)(resident ? rss : vm) * getpagesize();
     }
     return size;
 
@@ -90,6 +95,72 @@ static inline void _oct_SetupInitInfo(Oct_InitInfo *initInfo) {
     ctx->initInfo = initInfo;
 }
 
+/*
+ * Threads are only ever pinned to cores the process was allowed to run on when the engine started (taskset, cgroups,
+ * etc.), which are read once before any thread is pinned. Slots are handed cores from that list in order, and any slot
+ * past the end of it stays on the whole allowed set instead of doubling up on a core some other thread has to itself.
+ * Linux threads start with the affinity of whatever created them, so the render thread pins itself only after every
+ * engine thread has been created and threads that aren't pinned put the whole allowed set back.
+ */
+#ifdef __linux__
+static cpu_set_t gAllowedCoreSet;
+static int32_t *gAllowedCores;
+static int32_t gAllowedCoreCount;
+#endif
+
+// Records which cores the process may run on, must be called before anything is pinned
+static void _oct_ReadAllowedCores() {
+#ifdef __linux__
+    CPU_ZERO(&gAllowedCoreSet);
+    if (sched_getaffinity(0, sizeof(gAllowedCoreSet), &gAllowedCoreSet) != 0) {
+        oct_Raise(OCT_STATUS_ERROR, false, "Failed to read the allowed cores, assuming every core is allowed.");
+        for (int i = 0; i < SDL_GetNumLogicalCPUCores() && i < CPU_SETSIZE; i++)
+            CPU_SET(i, &gAllowedCoreSet);
+    }
+    gAllowedCores = mi_malloc(sizeof(int32_t) * CPU_COUNT(&gAllowedCoreSet));
+    if (!gAllowedCores)
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate allowed core list.");
+    gAllowedCoreCount = 0;
+    for (int i = 0; i < CPU_SETSIZE; i++)
+        if (CPU_ISSET(i, &gAllowedCoreSet))
+            gAllowedCores[gAllowedCoreCount++] = i;
+#endif
+}
+
+int32_t _oct_AllowedCoreCount() {
+#ifdef __linux__
+    if (gAllowedCoreCount > 0)
+        return gAllowedCoreCount;
+#endif
+    return SDL_GetNumLogicalCPUCores();
+}
+
+int32_t _oct_CoreForThreadSlot(int32_t slot) {
+#ifdef __linux__
+    if (slot >= 0 && slot < gAllowedCoreCount)
+        return gAllowedCores[slot];
+#endif
+    return -1;
+}
+
+void _oct_PinThread(int32_t slot) {
+    Oct_Context ctx = _oct_GetCtx();
+    if (!ctx->initInfo->pinThreads)
+        return;
+#ifdef __linux__
+    const int32_t core = _oct_CoreForThreadSlot(slot);
+    cpu_set_t set;
+    if (core >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+    } else {
+        set = gAllowedCoreSet;
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        oct_Raise(OCT_STATUS_ERROR, false, "Failed to pin thread to core %i.", core);
+#endif
+}
+
 // Returns the number of seconds from start, which should be a SDL_GetPerformanceCounter call
 inline static double _oct_GoofyTime(uint64_t start) {
     const double current = SDL_GetPerformanceCounter();
@@ -116,7 +187,7 @@ void _oct_DebugUpdate() {
     };
 
     // Draw nuklear debug thing
-    if (nk_begin(vk2dGuiContext(), "Performance", nk_rect(10, 10, 300, 220),
+    if (nk_begin(vk2dGuiContext(), "Performance", nk_rect(10, 10, 300, 340),
                  NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_TITLE)) {
 
         // Host info
@@ -129,13 +200,21 @@ void _oct_DebugUpdate() {
         float inUse, total;
         vk2dRendererGetVRAMUsage(&inUse, &total);
         nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "VRAM: %.2fmb/%.2fmb", inUse, total);
-        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "RAM: %.2fmb/%.2fgb", (double)memory_used(false) / 1024 / 1024, (double)SDL_GetSystemRAM() / 1024);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "RAM: %.2fmb/%.2fgb", (double)memory_used(true) / 1024 / 1024, (double)SDL_GetSystemRAM() / 1024);
         nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Interpolations/frame: %0.2f", _oct_DrawingGetAverageInterpolationCalls());
         nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Interpolation time: %0.2fµs", _oct_DrawingGetAverageInterpolationTime() * 1000000);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Job wake latency: %0.2fµs", _oct_JobsGetAverageWakeLatency() * 1000000);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Job threads parked: %0.1f%%", _oct_JobsGetParkedPercent() * 100);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Job backlog: %i critical, %i background", oct_GetJobBacklog(OCT_JOB_PRIORITY_CRITICAL), oct_GetJobBacklog(OCT_JOB_PRIORITY_BACKGROUND));
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Commands: %0.2fkb/frame (%0.2fkb saved)", _oct_CommandBufferGetAverageBytesPerFrame() / 1024, _oct_CommandBufferGetAverageBytesSavedPerFrame() / 1024);
+        Oct_CommandBufferStats commandStats;
+        oct_GetCommandBufferStats(&commandStats);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Command peak: %0.2f/%0.2fkb, %0.2f stalls", (double)commandStats.peakOccupancy / 1024, (double)commandStats.capacity / 1024, commandStats.stallsPerFrame);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Queued commands: %i load, %i audio", oct_GetCommandLaneBacklog(OCT_COMMAND_LANE_LOAD), oct_GetCommandLaneBacklog(OCT_COMMAND_LANE_AUDIO));
     }
     nk_end(vk2dGuiContext());
 
-    if (nk_begin(vk2dGuiContext(), "Assets", nk_rect(10, 240, 300, 350),
+    if (nk_begin(vk2dGuiContext(), "Assets", nk_rect(10, 360, 300, 350),
                  NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE |
                  NK_WINDOW_MINIMIZABLE | NK_WINDOW_TITLE)) {
 
@@ -174,6 +253,35 @@ void _oct_DebugUpdate() {
     }
     nk_end(vk2dGuiContext());
 
+    // Job system
+    if (nk_begin(vk2dGuiContext(), "Jobs", nk_rect(320, 240, 330, 220),
+                 NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE |
+                 NK_WINDOW_MINIMIZABLE | NK_WINDOW_TITLE)) {
+        nk_layout_row_dynamic(vk2dGuiContext(), 20, 1);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Scratch high-water marks");
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Logic thread: %.2fkb", (double)_oct_JobsGetScratchHighWater(_oct_JobsGetThreadCount()) / 1024);
+        for (int i = 0; i < _oct_JobsGetThreadCount(); i++)
+            nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Job thread %i: %.2fkb", i, (double)_oct_JobsGetScratchHighWater(i) / 1024);
+    }
+    nk_end(vk2dGuiContext());
+
+    // Memory
+    if (nk_begin(vk2dGuiContext(), "Memory", nk_rect(320, 470, 330, 240),
+                 NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE |
+                 NK_WINDOW_MINIMIZABLE | NK_WINDOW_TITLE)) {
+        Oct_AllocatorStats frameStats;
+        float history[120];
+        _oct_CommandBufferGetFrameMemoryStats(&frameStats);
+        const int32_t historyCount = _oct_CommandBufferGetFrameMemoryHistory(history, 120);
+        nk_layout_row_dynamic(vk2dGuiContext(), 20, 1);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Frame memory: %.2f/%.2fkb, %i pages", (double)frameStats.bytesAllocated / 1024, (double)frameStats.bytesReserved / 1024, frameStats.pageCount);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Frame allocations: %i", frameStats.allocationCount);
+        nk_labelf(vk2dGuiContext(), NK_TEXT_LEFT, "Frame memory high-water: %.2fkb", (double)frameStats.peakBytesAllocated / 1024);
+        nk_layout_row_dynamic(vk2dGuiContext(), 100, 1);
+        nk_plot(vk2dGuiContext(), NK_CHART_LINES, history, historyCount, 0);
+    }
+    nk_end(vk2dGuiContext());
+
     // Audio interface
     if (nk_begin(vk2dGuiContext(), "Audio", nk_rect(320, 10, 330, 220),
                  NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE |
@@ -215,22 +323,24 @@ void _oct_DebugEnd() {
 
 }
 
-OCTARINE_API Oct_Status oct_Init(Oct_InitInfo *initInfo) {
-    // Initialization
+// Creates the context and starts every subsystem besides the logic thread
+static void _oct_StartEngine(Oct_InitInfo *initInfo) {
     Oct_Context ctx = mi_zalloc(sizeof(struct Oct_Context_t));
     gInternalCtx = ctx;
     ctx->gameStartTime = SDL_GetPerformanceCounter();
     SDL_Init(SDL_INIT_EVENTS | SDL_INIT_GAMEPAD | SDL_INIT_AUDIO);
     PHYSFS_init(initInfo->argv[0]);
     _oct_SetupInitInfo(initInfo);
+    _oct_ReadAllowedCores();
     _oct_ValidationInit();
     _oct_WindowInit();
     _oct_DrawingInit();
     _oct_AudioInit();
+    _oct_JobsInit();
     _oct_CommandBufferInit();
     _oct_AssetsInit();
+    _oct_CaptureInit();
     _oct_DebugInit();
-    _oct_JobsInit();
 
     // Debug settings
     if (ctx->initInfo->debug) {
@@ -239,9 +349,69 @@ OCTARINE_API Oct_Status oct_Init(Oct_InitInfo *initInfo) {
         mi_option_enable(mi_option_show_stats);
         mi_option_enable(mi_option_verbose);
     }
+}
 
-    // Bootstrap thread
+// Shuts down every subsystem and frees the context, the logic thread must already be done
+static void _oct_StopEngine() {
+    Oct_Context ctx = _oct_GetCtx();
+    vk2dRendererWait();
+    _oct_DebugEnd();
+    _oct_JobsEnd();
+    _oct_CaptureEnd();
+    _oct_AssetsEnd();
+    _oct_CommandBufferEnd();
+    _oct_AudioEnd();
+    _oct_DrawingEnd();
+    _oct_WindowEnd();
+    _oct_ValidationEnd();
+    PHYSFS_deinit();
+#ifdef __linux__
+    mi_free(gAllowedCores);
+#endif
+    mi_free(ctx);
+}
+
+/*
+ * Headless mode starts only the job system and the command buffer so the benchmarks in tools/ can run without a
+ * window, renderer, or audio device. The thread that calls _oct_StartHeadless plays the logic thread, and whichever
+ * thread calls _oct_CommandBufferDispatch plays the render thread, which throws every command away after the command
+ * buffer is done with it. It can be started and stopped as many times as needed, but never while oct_Init is running.
+ */
+void _oct_StartHeadless(Oct_InitInfo *initInfo) {
+    Oct_Context ctx = mi_zalloc(sizeof(struct Oct_Context_t));
+    gInternalCtx = ctx;
+    ctx->headless = true;
+    ctx->gameStartTime = SDL_GetPerformanceCounter();
+    _oct_SetupInitInfo(initInfo);
+    _oct_ReadAllowedCores();
+    _oct_ValidationInit();
+    _oct_JobsInit();
+    _oct_CommandBufferInit();
+    _oct_JobsBeginFrame();
+}
+
+void _oct_StopHeadless() {
+    Oct_Context ctx = _oct_GetCtx();
+    SDL_SetAtomicInt(&ctx->quit, 1);
+    _oct_JobsEnd();
+    _oct_CommandBufferEnd();
+    _oct_ValidationEnd();
+#ifdef __linux__
+    mi_free(gAllowedCores);
+    gAllowedCores = null;
+#endif
+    mi_free(ctx);
+    gInternalCtx = null;
+}
+
+OCTARINE_API Oct_Status oct_Init(Oct_InitInfo *initInfo) {
+    // Initialization
+    _oct_StartEngine(initInfo);
+    Oct_Context ctx = _oct_GetCtx();
+
+    // Bootstrap thread, the render thread is pinned after so threads created along the way don't inherit its core
     oct_Bootstrap();
+    _oct_PinThread(OCT_THREAD_SLOT_RENDER);
 
     // Timekeeping
     float frameCount = 0;
@@ -294,16 +464,83 @@ OCTARINE_API Oct_Status oct_Init(Oct_InitInfo *initInfo) {
     // Cleanup
     vk2dRendererWait();
     _oct_UnstrapBoots();
-    _oct_DebugEnd();
-    _oct_JobsEnd();
-    _oct_AssetsEnd();
-    _oct_CommandBufferEnd();
-    _oct_AudioEnd();
-    _oct_DrawingEnd();
-    _oct_WindowEnd();
-    _oct_ValidationEnd();
-    PHYSFS_deinit();
-    mi_free(ctx);
+    _oct_StopEngine();
+    return OCT_STATUS_SUCCESS;
+}
+
+static int _oct_CompareDoubles(const void *a, const void *b) {
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return x < y ? -1 : (x > y);
+}
+
+OCTARINE_API Oct_Status oct_Replay(Oct_InitInfo *initInfo, const char *captureFile, const char *timingsFile) {
+    // A replay must not capture itself
+    initInfo->captureFile = null;
+    _oct_StartEngine(initInfo);
+    Oct_Context ctx = _oct_GetCtx();
+    if (!_oct_ReplayOpen(captureFile)) {
+        _oct_StopEngine();
+        return OCT_STATUS_FILE_DOES_NOT_EXIST;
+    }
+
+    // Nothing is interpolating between logic frames, always draw the newest one
+    SDL_SetAtomicInt(&ctx->interpolatedTime, OCT_FLOAT_TO_INT(1.0f));
+
+    // Render every captured frame as fast as possible
+    double *times = null;
+    int32_t frames = 0;
+    int32_t capacity = 0;
+    while (SDL_GetAtomicInt(&ctx->quit) == 0) {
+        const uint64_t startTime = SDL_GetPerformanceCounter();
+        _oct_WindowUpdateBegin();
+        _oct_AudioUpdateBegin();
+        _oct_DrawingUpdateBegin();
+        if (!_oct_ReplayFrame())
+            break;
+        _oct_WindowUpdateEnd();
+        _oct_AudioUpdateEnd();
+        _oct_DrawingUpdateEnd();
+        _oct_DebugUpdate();
+        _oct_JobsUpdate();
+
+        if (frames == capacity) {
+            capacity = capacity == 0 ? 1024 : capacity * 2;
+            double *newTimes = mi_realloc(times, sizeof(double) * capacity);
+            if (!newTimes)
+                oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to grow replay timings to %i frames.", capacity);
+            times = newTimes;
+        }
+        times[frames++] = _oct_GoofyTime(startTime);
+    }
+
+    // Report timings
+    if (timingsFile && frames > 0) {
+        FILE *file = fopen(timingsFile, "w");
+        if (file) {
+            fprintf(file, "frame,ms\n");
+            for (int32_t i = 0; i < frames; i++)
+                fprintf(file, "%i,%f\n", i, times[i] * 1000);
+            fclose(file);
+        } else {
+            oct_Raise(OCT_STATUS_FILE_DOES_NOT_EXIST, false, "Failed to open replay timings file \"%s\".", timingsFile);
+        }
+    }
+    if (frames > 0) {
+        double total = 0;
+        for (int32_t i = 0; i < frames; i++)
+            total += times[i];
+        qsort(times, frames, sizeof(double), _oct_CompareDoubles);
+        oct_Log("Replayed %i frames: average %.3fms, min %.3fms, median %.3fms, 99th percentile %.3fms, max %.3fms",
+                frames, (total / frames) * 1000, times[0] * 1000, times[frames / 2] * 1000,
+                times[(int32_t)((frames - 1) * 0.99)] * 1000, times[frames - 1] * 1000);
+    } else {
+        oct_Log("Command capture \"%s\" has no frames.", captureFile);
+    }
+    mi_free(times);
+
+    _oct_ReplayClose();
+    _oct_StopEngine();
     return OCT_STATUS_SUCCESS;
 }
 
@@ -9,16 +9,22 @@
 #include "oct/Assets.h"
 #include "oct/Blobs.h"
 
-// Thing in the draw command hash bucket
-typedef struct DrawCommandLink_t DrawCommandLink;
-struct DrawCommandLink_t {
-    Oct_DrawCommand *command; // Pointer to a command in the main draw command link in the frame command buffer thing
-    uint64_t id;              // Id for collision checking
-    uint64_t frame;           // Frame this is associated with so we don't need to clear the bucket each frame
-    int32_t next;             // Next in the chain for collision checking (this is an index to the backup bucket)
-};
-
-const int BUCKET_SIZE = 10000;
+/*
+ * Interpolated draws are matched up with the draw with the same id from the previous frame through a Robin Hood hash
+ * table kept per frame buffer. The table is open-addressed with a power of 2 capacity, a slot remembers how far it is
+ * from where its id hashes to and an insert takes the slot of any entry that's closer to home than it is, so probe
+ * lengths stay short and even, and a lookup can stop as soon as it passes an entry closer to home than it would be.
+ * Slots store the index of the command instead of a pointer so growing the command list can't leave them dangling.
+ * Each frame the table starts out sized for the number of interpolated draws the last frame that used it had, and
+ * doubles if it gets more than half full. Slots are only 16 bytes so the extra room is cheap and keeps probes short.
+ */
+typedef struct InterpolationSlot_t {
+    uint64_t id;      // Id of the draw
+    int32_t command;  // Index of the command in the frame's command list, -1 if the slot is empty
+    int32_t distance; // How far this slot is from where id hashes to
+} InterpolationSlot;
+
+#define MIN_INTERPOLATION_TABLE_SIZE 1024
 
 // Commands are tied to the frame they came from for interpolation and triple buffering
 typedef struct FrameCommandBuffer_t {
@@ -28,11 +34,11 @@ typedef struct FrameCommandBuffer_t {
     Oct_Bool singleBuffer;     ///< If this command buffer is only meant to be ran once
     Oct_Bool executed;         ///< If this is a single buffer and it has already been run
 
-    // Draw command hash bucket for interpolated draws
-    DrawCommandLink *bucket;
-    DrawCommandLink *backupBucket;
-    int backupBucketSize;
-    int backupBucketCount; // Set to 0 each time this starts working to make room for new links
+    // Table of interpolated draws
+    InterpolationSlot *table;
+    int32_t tableCapacity; ///< Always a power of 2
+    int32_t tableCount;    ///< Number of draws in the table
+    uint64_t tableFrame;   ///< Frame the draws in the table are from
 } FrameCommandBuffer;
 
 // Wraps an index (0 = 1, 1 = 2, 2 = 0)
@@ -63,65 +69,96 @@ uint64_t hash(uint64_t x) {
     return x;
 }
 
-// Puts a command into the hash bucket of a given frame
-static void addCommandToBucket(int index) {
-    Oct_DrawCommand *cmd = &gFrameBuffers[gCurrentFrame].commands[index];
-    uint64_t bucketLocation = hash(cmd->id) % BUCKET_SIZE;
-
-    if (gFrameBuffers[gCurrentFrame].bucket[bucketLocation].frame != gFrame) {
-        // This spot is empty
-        gFrameBuffers[gCurrentFrame].bucket[bucketLocation].command = cmd;
-        gFrameBuffers[gCurrentFrame].bucket[bucketLocation].id = cmd->id;
-        gFrameBuffers[gCurrentFrame].bucket[bucketLocation].frame = gFrame;
-        gFrameBuffers[gCurrentFrame].bucket[bucketLocation].next = -1;
-    } else {
-        // This spot is taken, find the end of the linked list
-        DrawCommandLink *current = &gFrameBuffers[gCurrentFrame].bucket[bucketLocation];
-        while (current->next != -1)
-            current = &gFrameBuffers[gCurrentFrame].backupBucket[current->next];
-
-        // Find a spot in the extended bucket list
-        if (gFrameBuffers[gCurrentFrame].backupBucketCount == gFrameBuffers[gCurrentFrame].backupBucketSize) {
-            void *temp = mi_realloc(gFrameBuffers[gCurrentFrame].backupBucket,
-                                    sizeof(struct DrawCommandLink_t) * (gFrameBuffers[gCurrentFrame].backupBucketSize + 10));
-            if (!temp)
-                oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to reallocate backup bucket.");
-            gFrameBuffers[gCurrentFrame].backupBucket = temp;
-            gFrameBuffers[gCurrentFrame].backupBucketSize += 10;
+// Allocates an empty table
+static void resetInterpolationTable(FrameCommandBuffer *frame, int32_t capacity) {
+    if (capacity != frame->tableCapacity) {
+        mi_free(frame->table);
+        frame->table = mi_malloc(sizeof(struct InterpolationSlot_t) * capacity);
+        if (!frame->table)
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate interpolation table of %i slots.", capacity);
+        frame->tableCapacity = capacity;
+    } else if (frame->tableCount == 0) {
+        return;
+    }
+    memset(frame->table, 0xFF, sizeof(struct InterpolationSlot_t) * capacity);
+    frame->tableCount = 0;
+}
+
+// Finds the slot a draw is in, or null if its not in the table
+static InterpolationSlot *findInterpolationSlot(FrameCommandBuffer *frame, uint64_t id) {
+    const uint32_t mask = frame->tableCapacity - 1;
+    int32_t distance = 0;
+    for (uint32_t i = hash(id) & mask;; i = (i + 1) & mask, distance++) {
+        InterpolationSlot *slot = &frame->table[i];
+
+        // Robin Hood order means id would have taken this slot if it were in the table
+        if (slot->command == -1 || slot->distance < distance)
+            return null;
+        if (slot->id == id)
+            return slot;
+    }
+}
+
+// Puts a draw into a table
+static void insertInterpolationSlot(FrameCommandBuffer *frame, uint64_t id, int32_t command) {
+    const uint32_t mask = frame->tableCapacity - 1;
+    InterpolationSlot slot = {.id = id, .command = command, .distance = 0};
+    for (uint32_t i = hash(id) & mask;; i = (i + 1) & mask) {
+        InterpolationSlot *current = &frame->table[i];
+        if (current->command == -1) {
+            *current = slot;
+            frame->tableCount++;
+            return;
         }
-        const int32_t extendedBucketSpot = gFrameBuffers[gCurrentFrame].backupBucketCount++;
 
-        current->next = extendedBucketSpot;
-        gFrameBuffers[gCurrentFrame].backupBucket[extendedBucketSpot].command = cmd;
-        gFrameBuffers[gCurrentFrame].backupBucket[extendedBucketSpot].id = cmd->id;
-        gFrameBuffers[gCurrentFrame].backupBucket[extendedBucketSpot].frame = gFrame;
-        gFrameBuffers[gCurrentFrame].backupBucket[extendedBucketSpot].next = -1;
+        // If the id is already in the table it shows up before the first swap, the first draw with an id is kept
+        if (current->id == id && slot.command == command)
+            return;
+
+        // Whichever is closer to home moves on
+        if (current->distance < slot.distance) {
+            const InterpolationSlot temp = *current;
+            *current = slot;
+            slot = temp;
+        }
+        slot.distance++;
     }
 }
 
-// Pulls a command from the previous frame's hash bucket or null if there is no match
-static Oct_DrawCommand *getCommandFromBucket(uint64_t id) {
-    // Get expected location
-    uint64_t bucketLocation = hash(id) % BUCKET_SIZE;
-
-    // Traverse linked list till we find it
-    DrawCommandLink *link = &gFrameBuffers[PREVIOUS_DRAW_FRAME].bucket[bucketLocation];
-    while (link) {
-        if (link->frame == gFrame - 1 && link->id == id)
-            return link->command;
-        else if (link->frame != gFrame - 1)
-            break;
-        if (link->next != -1)
-            link = &gFrameBuffers[PREVIOUS_DRAW_FRAME].backupBucket[link->next];
-        else
-            link = null;
+// Puts a command into the current frame's table
+static void addCommandToBucket(int index) {
+    FrameCommandBuffer *frame = &gFrameBuffers[gCurrentFrame];
+
+    // Keep the table at most half full
+    if ((frame->tableCount + 1) * 2 > frame->tableCapacity) {
+        InterpolationSlot *old = frame->table;
+        const int32_t oldCapacity = frame->tableCapacity;
+        frame->table = null;
+        frame->tableCapacity = 0;
+        frame->tableCount = 0;
+        resetInterpolationTable(frame, oldCapacity * 2);
+        for (int32_t i = 0; i < oldCapacity; i++)
+            if (old[i].command != -1)
+                insertInterpolationSlot(frame, old[i].id, old[i].command);
+        mi_free(old);
     }
+    frame->tableFrame = gFrame;
+    insertInterpolationSlot(frame, frame->commands[index].id, index);
+}
 
-    return null;
+// Pulls a command from the previous frame's table or null if there is no match
+static Oct_DrawCommand *getCommandFromBucket(uint64_t id) {
+    FrameCommandBuffer *frame = &gFrameBuffers[PREVIOUS_DRAW_FRAME];
+    if (frame->tableCount == 0 || frame->tableFrame != gFrame - 1)
+        return null;
+
+    InterpolationSlot *slot = findInterpolationSlot(frame, id);
+    return slot ? &frame->commands[slot->command] : null;
 }
 
 ///////////////////// Internal functions /////////////////////
-// Adds a command to the current frame buffer, expanding if necessary
+// Adds a command to the current frame buffer, expanding if necessary, only the part of the command its type uses is
+// copied since that's all the ring buffer carries
 void addCommand(Oct_DrawCommand *cmd) {
     // Need more buffer space
     if (gFrameBuffers[gCurrentFrame].size == gFrameBuffers[gCurrentFrame].count) {
@@ -131,7 +168,7 @@ void addCommand(Oct_DrawCommand *cmd) {
             oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to expand frame buffer.");
         }
     }
-    memcpy(&gFrameBuffers[gCurrentFrame].commands[gFrameBuffers[gCurrentFrame].count++], cmd, sizeof(struct Oct_DrawCommand_t));
+    memcpy(&gFrameBuffers[gCurrentFrame].commands[gFrameBuffers[gCurrentFrame].count++], cmd, _oct_DrawCommandSize(cmd->type));
     if (cmd->interpolate != 0)
         addCommandToBucket(gFrameBuffers[gCurrentFrame].count - 1);
 }
@@ -161,7 +198,7 @@ void _oct_DrawingInit() {
     for (int i = 0; i < 3; i++) {
         gFrameBuffers[i].size = ctx->initInfo->ringBufferSize;
         gFrameBuffers[i].commands = mi_malloc(gFrameBuffers[i].size * sizeof(struct Oct_DrawCommand_t));
-        gFrameBuffers[i].bucket = mi_zalloc(sizeof(struct DrawCommandLink_t) * BUCKET_SIZE);
+        resetInterpolationTable(&gFrameBuffers[i], MIN_INTERPOLATION_TABLE_SIZE);
     }
 
     // Allocate debug font
@@ -184,8 +221,7 @@ void _oct_DrawingEnd() {
     // Free frame buffers
     for (int i = 0; i < 3; i++) {
         mi_free(gFrameBuffers[i].commands);
-        mi_free(gFrameBuffers[i].bucket);
-        mi_free(gFrameBuffers[i].backupBucket);
+        mi_free(gFrameBuffers[i].table);
     }
 
     vk2dRendererQuit();
@@ -201,22 +237,28 @@ double _oct_DrawingGetAverageInterpolationTime() {
 
 void _oct_DrawingUpdateBegin() { }
 
-void _oct_DrawingProcessCommand(Oct_Command *cmd) {
-    if (OCT_STRUCTURE_TYPE(&cmd->topOfUnion) == OCT_STRUCTURE_TYPE_META_COMMAND) {
-        if (cmd->metaCommand.type == OCT_META_COMMAND_TYPE_END_FRAME || cmd->metaCommand.type == OCT_META_COMMAND_TYPE_END_SINGLE_FRAME) {
+void _oct_DrawingProcessCommand(void *command) {
+    if (OCT_STRUCTURE_TYPE(command) == OCT_STRUCTURE_TYPE_META_COMMAND) {
+        Oct_MetaCommand *meta = command;
+        if (meta->type == OCT_META_COMMAND_TYPE_END_FRAME || meta->type == OCT_META_COMMAND_TYPE_END_SINGLE_FRAME) {
             gCurrentFrame = NEXT_INDEX(gCurrentFrame);
             gFrameBuffers[gCurrentFrame].count = 0;
-            gFrameBuffers[gCurrentFrame].backupBucketCount = 0;
+
+            // Size the table for as many interpolated draws as the last frame that used this buffer had
+            int32_t capacity = MIN_INTERPOLATION_TABLE_SIZE;
+            while (gFrameBuffers[gCurrentFrame].tableCount * 2 > capacity)
+                capacity *= 2;
+            resetInterpolationTable(&gFrameBuffers[gCurrentFrame], capacity);
             gFrameBuffers[gCurrentFrame].executed = false;
             gFrameBuffers[gCurrentFrame].singleBuffer = false;
 
-            if (cmd->metaCommand.type == OCT_META_COMMAND_TYPE_END_SINGLE_FRAME)
+            if (meta->type == OCT_META_COMMAND_TYPE_END_SINGLE_FRAME)
                 gFrameBuffers[gCurrentFrame].singleBuffer = true;
-        } else if (cmd->metaCommand.type == OCT_META_COMMAND_TYPE_START_FRAME || cmd->metaCommand.type == OCT_META_COMMAND_TYPE_START_SINGLE_FRAME) {
+        } else if (meta->type == OCT_META_COMMAND_TYPE_START_FRAME || meta->type == OCT_META_COMMAND_TYPE_START_SINGLE_FRAME) {
             gFrame++;
         }
     } else {
-        addCommand(&cmd->drawCommand);
+        addCommand(command);
     }
 }
 
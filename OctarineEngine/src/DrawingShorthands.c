@@ -178,6 +178,7 @@ OCTARINE_API void oct_DrawShaderIntColourExt(Oct_InterpolationType interp, uint6
             .Shader = {
                     .shader = shader,
                     .uniformData = shaderData,
+                    .uniformSize = size,
                     .texture = texture,
                     .viewport = {0, 0, OCT_WHOLE_TEXTURE, OCT_WHOLE_TEXTURE},
                     .position = {position[0], position[1]},
@@ -335,6 +336,105 @@ OCTARINE_API void oct_DrawSpriteFrameColourExt(Oct_Sprite sprite, int32_t frame,
     oct_DrawSpriteFrameIntColourExt(0, 0, sprite, frame, colour, position, scale, rotation, origin);
 }
 
+/////////////////////////////////////// BATCHES ///////////////////////////////////////
+// Batch helpers build commands in chunks on the stack and hand each chunk to oct_DrawBatch
+#define DRAW_BATCH_CHUNK 128
+
+OCTARINE_API void oct_DrawRectangleBatch(const Oct_Rectangle *rectangles, int32_t count, Oct_Bool filled, float lineWidth) {
+    Oct_DrawCommand cmds[DRAW_BATCH_CHUNK];
+    for (int32_t start = 0; start < count; start += DRAW_BATCH_CHUNK) {
+        const int32_t chunk = SDL_min(count - start, DRAW_BATCH_CHUNK);
+        for (int32_t i = 0; i < chunk; i++) {
+            const Oct_Rectangle *rectangle = &rectangles[start + i];
+            cmds[i] = (Oct_DrawCommand){
+                    .sType = OCT_STRUCTURE_TYPE_DRAW_COMMAND,
+                    .type = OCT_DRAW_COMMAND_TYPE_RECTANGLE,
+                    .colour = _OCT_WHITE,
+                    .Rectangle = {
+                            .rectangle = {
+                                    .position = {rectangle->position[0], rectangle->position[1]},
+                                    .size = {rectangle->size[0], rectangle->size[1]},
+                            },
+                            .filled = filled,
+                            .lineSize = lineWidth,
+                    }
+            };
+        }
+        oct_DrawBatch(cmds, chunk);
+    }
+}
+
+OCTARINE_API void oct_DrawTextureBatch(Oct_Texture texture, const Oct_Vec2 *positions, int32_t count) {
+    Oct_DrawCommand cmds[DRAW_BATCH_CHUNK];
+    for (int32_t start = 0; start < count; start += DRAW_BATCH_CHUNK) {
+        const int32_t chunk = SDL_min(count - start, DRAW_BATCH_CHUNK);
+        for (int32_t i = 0; i < chunk; i++) {
+            cmds[i] = (Oct_DrawCommand){
+                    .sType = OCT_STRUCTURE_TYPE_DRAW_COMMAND,
+                    .type = OCT_DRAW_COMMAND_TYPE_TEXTURE,
+                    .colour = _OCT_WHITE,
+                    .Texture = {
+                            .texture = texture,
+                            .viewport = {0, 0, OCT_WHOLE_TEXTURE, OCT_WHOLE_TEXTURE},
+                            .position = {positions[start + i][0], positions[start + i][1]},
+                            .scale = {1, 1},
+                    }
+            };
+        }
+        oct_DrawBatch(cmds, chunk);
+    }
+}
+
+OCTARINE_API void oct_DrawSpriteFrameBatch(Oct_Sprite sprite, int32_t frame, const Oct_Vec2 *positions, int32_t count) {
+    Oct_DrawCommand cmds[DRAW_BATCH_CHUNK];
+    for (int32_t start = 0; start < count; start += DRAW_BATCH_CHUNK) {
+        const int32_t chunk = SDL_min(count - start, DRAW_BATCH_CHUNK);
+        for (int32_t i = 0; i < chunk; i++) {
+            cmds[i] = (Oct_DrawCommand){
+                    .sType = OCT_STRUCTURE_TYPE_DRAW_COMMAND,
+                    .type = OCT_DRAW_COMMAND_TYPE_SPRITE,
+                    .colour = _OCT_WHITE,
+                    .Sprite = {
+                            .sprite = sprite,
+                            .viewport = {0, 0, OCT_WHOLE_TEXTURE, OCT_WHOLE_TEXTURE},
+                            .position = {positions[start + i][0], positions[start + i][1]},
+                            .scale = {1, 1},
+                            .frame = frame,
+                    }
+            };
+        }
+        oct_DrawBatch(cmds, chunk);
+    }
+}
+
+OCTARINE_API void oct_DrawSpriteBatchInt(Oct_InterpolationType interp, const uint64_t *ids, Oct_Sprite sprite, Oct_SpriteInstance *instances, const Oct_Vec2 *positions, int32_t count) {
+    Oct_DrawCommand cmds[DRAW_BATCH_CHUNK];
+    for (int32_t start = 0; start < count; start += DRAW_BATCH_CHUNK) {
+        const int32_t chunk = SDL_min(count - start, DRAW_BATCH_CHUNK);
+        for (int32_t i = 0; i < chunk; i++) {
+            cmds[i] = (Oct_DrawCommand){
+                    .sType = OCT_STRUCTURE_TYPE_DRAW_COMMAND,
+                    .type = OCT_DRAW_COMMAND_TYPE_SPRITE,
+                    .colour = _OCT_WHITE,
+                    .interpolate = interp,
+                    .id = ids ? ids[start + i] : 0,
+                    .Sprite = {
+                            .sprite = sprite,
+                            .viewport = {0, 0, OCT_WHOLE_TEXTURE, OCT_WHOLE_TEXTURE},
+                            .position = {positions[start + i][0], positions[start + i][1]},
+                            .scale = {1, 1},
+                            .frame = _oct_ProcessSpriteUpdate(&instances[start + i], sprite),
+                    }
+            };
+        }
+        oct_DrawBatch(cmds, chunk);
+    }
+}
+
+OCTARINE_API void oct_DrawSpriteBatch(Oct_Sprite sprite, Oct_SpriteInstance *instances, const Oct_Vec2 *positions, int32_t count) {
+    oct_DrawSpriteBatchInt(0, null, sprite, instances, positions, count);
+}
+
 /////////////////////////////////////// CAMERA ///////////////////////////////////////
 OCTARINE_API void oct_UpdateCameraInt(Oct_InterpolationType interp, uint64_t id, Oct_Camera camera, Oct_CameraUpdate *update) {
     Oct_DrawCommand cmd = {
@@ -1,115 +1,1190 @@
+#ifdef __linux__
+# define _GNU_SOURCE // for ucontext
+# include <ucontext.h>
+# define OCT_JOB_FIBERS
+#endif
 #include <SDL3/SDL.h>
 #include "oct/Validation.h"
 #include "oct/JobSystem.h"
+#include "oct/Core.h"
 #include "oct/Opaque.h"
 #include "oct/Subsystems.h"
+#include "oct/Allocators.h"
+#ifdef OCT_JOB_TRACE
+#include <stdarg.h>
+#include "oct/Util.h"
+#endif
 
-typedef struct Job_t {
-    Oct_JobFunction job;
-    void *ptr;
-} Job;
+#define JOB_INDEX(job) (job & UINT32_MAX)
+#define JOB_GENERATION(job) ((uint32_t)(job >> 32))
+
+/*
+ * Jobs live in a fixed pool of job nodes and are handed to the user as an index + generation, the same way sounds
+ * are. A node's generation is bumped the moment the job finishes so any handle that doesn't match the node's current
+ * generation is a finished job.
+ *
+ * Dependencies are tracked with a counter on the waiting job and a list of continuations on every job it waits on.
+ * The links in those lists are owned by the waiting job, so nothing needs to be allocated to add a dependency in the
+ * common case. When a job finishes it walks its continuations and decrements each one's counter, and whoever takes
+ * a counter to zero schedules that job.
+ */
+#define JOB_POOL_SIZE 4096 // must be a power of 2
+#define JOB_POOL_MASK (JOB_POOL_SIZE - 1)
+#define JOB_INLINE_LINKS 4 // dependencies past this many get their links from the heap
+
+typedef struct JobNode_t JobNode;
+typedef struct JobLink_t JobLink;
+typedef struct JobFiber_t JobFiber;
+
+// A running oct_ParallelFor, lives on the stack of the thread that called it
+typedef struct ParallelFor_t {
+    Oct_ParallelForFunction function; // Function to call on each range
+    void *data;                       // User data
+    int32_t grain;                    // Size of the smallest range that will be handed to function
+    Oct_DrawSortKey drawKey;          // Key draws made from every range start with
+    SDL_AtomicInt remaining;          // Number of items that haven't been processed yet
+} ParallelFor;
+
+// A link in a job's continuation list
+struct JobLink_t {
+    JobNode *dependent; // Job waiting on the job this link is attached to
+    JobLink *next;      // Next continuation
+};
+
+struct JobNode_t {
+    Oct_JobFunction job;                    // Function to run, may be null for pure join points
+    void *ptr;                              // User data
+    ParallelFor *parallelFor;               // If this is not null, this job is a range of a parallel for instead
+    int32_t rangeStart;                     // Start of the parallel for range
+    int32_t rangeEnd;                       // End of the parallel for range (exclusive)
+    Oct_JobPriority priority;               // Lane this job is queued in
+    Oct_Bool fiberJob;                      // Runs on its own fiber so it can be suspended while it waits
+    JobFiber *fiber;                        // Fiber the job is running on once it has started
+    uint64_t scheduleTime;                  // When this job was put in a queue, for wake latency stats
+    Oct_DrawSortKey drawKey;                // Sort key for draws made from this job, see newDrawSortKey
+#ifdef OCT_JOB_TRACE
+    Oct_Bool traceStolen;                   // Whether the job was stolen from another thread's deque
+    int32_t traceQueueDepth;                // Jobs left in the lane when this one was taken
+#endif
+    SDL_AtomicInt reserved;                 // Whether or not this node is in use
+    SDL_AtomicInt generation;               // Bumped when the job finishes
+    SDL_AtomicInt dependencies;             // Unfinished jobs this job is waiting on
+    SDL_AtomicInt waiters;                  // Threads blocked in oct_WaitJob on this job
+    SDL_SpinLock lock;                      // Guards the continuation list and generation changes
+    JobLink *continuations;                 // Jobs waiting on this one
+    JobLink *links;                         // Links this job places in its dependencies' continuation lists
+    JobLink inlineLinks[JOB_INLINE_LINKS];  // Storage for links in the common case
+};
+
+/*
+ * Each job thread owns a Chase-Lev deque it pushes and pops from the bottom of, while idle job threads steal from
+ * the top of a random victim's deque. Threads that are not job threads (usually the logic thread) can't own a deque
+ * so they push into a lock-free global injection queue that every job thread pulls from. Indices are unsigned and
+ * allowed to wrap, only differences between them are ever looked at.
+ */
+#define JOB_DEQUE_SIZE 1024 // must be a power of 2
+#define JOB_DEQUE_MASK (JOB_DEQUE_SIZE - 1)
+#define JOB_INJECTION_QUEUE_SIZE 4096 // must be a power of 2
+#define JOB_INJECTION_QUEUE_MASK (JOB_INJECTION_QUEUE_SIZE - 1)
+
+typedef struct JobDeque_t {
+    SDL_AtomicU32 top;    // Thieves take from here
+    uint8_t padding[60];  // Keeps thieves and the owner off the same cache line
+    SDL_AtomicU32 bottom; // The owner pushes/pops here
+    JobNode *jobs[JOB_DEQUE_SIZE];
+} JobDeque;
+
+typedef struct InjectionCell_t {
+    SDL_AtomicU32 sequence; // Tells producers/consumers whose turn it is for this cell
+    JobNode *job;
+} InjectionCell;
+
+typedef struct InjectionQueue_t {
+    InjectionCell cells[JOB_INJECTION_QUEUE_SIZE];
+    SDL_AtomicU32 head; // reading end
+    SDL_AtomicU32 tail; // writing end
+} InjectionQueue;
+
+/*
+ * Every priority gets its own set of deques and its own injection queue. Job threads always drain the critical lane
+ * before looking at the background lane, except that after running JOB_STARVATION_LIMIT critical jobs in a row while
+ * background jobs are waiting a job thread takes one background job first so it is never starved outright.
+ */
+#define JOB_STARVATION_LIMIT 64
+
+/*
+ * Job threads that can't find work spin for a little while (longer if spinning has been paying off lately) and then
+ * park on a condition variable. Anything that queues a job wakes a parked thread, but only bothers locking the mutex
+ * if it sees someone is parked. Since a thread announces it's parking before it checks the queues one last time, and
+ * queueing checks for parked threads after the job is already in a queue, one of the two always sees the other.
+ * Threads waiting on jobs to complete work the same way with their own condition.
+ */
+#define JOB_SPIN_MIN 16
+#define JOB_SPIN_MAX 4096
+
+/*
+ * Every job thread plus the logic thread gets its own virtual page allocator for scratch memory so jobs can grab
+ * temporary memory without locks or mimalloc. Scratch allocators are only ever touched by the thread they belong to,
+ * including when they are reset: job threads check if a new logic frame has started before each top-level job (never
+ * while a job is running, since a job that helps out while it waits would otherwise lose its memory) and the logic
+ * thread resets its own at the start of every frame.
+ */
+typedef struct JobScratch_t {
+    Oct_Allocator allocator;
+    uint32_t frame;          // Logic frame this scratch memory was last reset on
+    SDL_AtomicInt highWater; // Most bytes used in a single frame, for the debug overlay
+} JobScratch;
+
+#ifdef OCT_JOB_TRACE
+/*
+ * When the engine is built with OCTARINE_JOB_TRACE, every job run on a thread with a slot (job threads and the logic
+ * thread) is recorded in that thread's own ring of events, so recording is just a few stores and never contends with
+ * other threads. oct_DumpJobTrace reads the rings without stopping anyone, so events written while it runs may come
+ * out torn; dump at the end of a frame when you can. Without the option none of this exists.
+ */
+#define JOB_TRACE_EVENTS 16384 // per thread, must be a power of 2
+#define JOB_TRACE_EVENTS_MASK (JOB_TRACE_EVENTS - 1)
+#define JOB_TRACE_FRAMES 256 // must be a power of 2
+#define JOB_TRACE_FRAMES_MASK (JOB_TRACE_FRAMES - 1)
+
+typedef struct JobTraceEvent_t {
+    uint64_t queued;            // When the job was put in a queue
+    uint64_t start;             // When the job started running
+    uint64_t end;               // When the job finished running
+    void *function;             // Job function or parallel for function
+    uint32_t frame;             // Logic frame the job started in
+    int32_t queueDepth;         // Jobs left in the lane when this one was taken
+    Oct_JobPriority priority;   // Lane the job was in
+    Oct_Bool stolen;            // Taken from another job thread's deque
+    Oct_Bool parallelFor;       // Range of a parallel for
+} JobTraceEvent;
+
+typedef struct JobTrace_t {
+    JobTraceEvent events[JOB_TRACE_EVENTS];
+    SDL_AtomicU32 count; // Total events ever recorded, the next is written to count & mask
+    SDL_AtomicU32 steals; // Total jobs this thread stole
+} JobTrace;
+#endif
+
+#ifdef OCT_JOB_FIBERS
+/*
+ * Fiber jobs run on their own stack. When one calls oct_WaitJob on a job that isn't done, it swaps back to whatever
+ * thread ran it and that thread adds the fiber job as a continuation of the job it is waiting on, then goes on to
+ * run other jobs. The continuation is only added once the fiber has fully swapped out so it can't be resumed on
+ * another thread while it is still running here. Once the job being waited on finishes the fiber job is queued again
+ * like any other job and resumes on whichever thread picks it up.
+ */
+#define JOB_FIBER_STACK_SIZE (256 * 1024)
+
+struct JobFiber_t {
+    ucontext_t context;         // Where the fiber is suspended
+    ucontext_t *returnContext;  // Thread that is currently running the fiber
+    void *stack;                // Fiber stack
+    JobNode *node;              // Job this fiber is running
+    Oct_Job waitingOn;          // Job the fiber suspended to wait on
+    Oct_Bool finished;          // The job function returned
+    JobLink link;               // Continuation link used while suspended
+    JobFiber *next;             // Next in the free list
+    JobFiber *allNext;          // Next in the list of every fiber, for cleanup
+};
+#endif
+
+// Per job thread stats, only ever written by the job thread they belong to
+typedef struct JobThreadStats_t {
+    uint64_t jobsRun;     // Total jobs run
+    uint64_t wakeLatency; // Total time (performance counter) between jobs being queued and starting
+    uint64_t parkedTime;  // Total time (performance counter) spent parked
+} JobThreadStats;
 
 // Globals
-#define JOB_RINGBUFFER_SIZE 25
 SDL_Thread **gJobThreads;
 uint32_t gJobThreadCount;
 SDL_AtomicInt gThreadsWorking;
+static JobDeque *gJobDeques[OCT_JOB_PRIORITY_MAX]; // One per job thread per lane
+static SDL_TLSID gWorkerIndex; // Index + 1 of the job thread, 0 for threads that aren't job threads
+static SDL_TLSID gCurrentFiber; // Fiber running on this thread, null if it isn't running a fiber job
+static SDL_TLSID gThreadSlot; // Index + 1 of the thread's scratch/trace slot (job threads then the logic thread), 0 for other threads
+static SDL_TLSID gDrawSortKey; // Sort key of the job or parallel for range running on this thread, null outside of jobs
+static SDL_AtomicInt gJobSubmissions; // Jobs and parallel fors queued this logic frame
+static JobNode gJobPool[JOB_POOL_SIZE];
+static SDL_AtomicInt gJobPoolCursor; // Where the next search for a free node starts
+
+// Scratch memory, one per job thread followed by one for the logic thread
+static JobScratch *gJobScratch;
+static SDL_AtomicU32 gJobFrame; // Incremented at the start of each logic frame
+
+#ifdef OCT_JOB_TRACE
+// Tracing, one per job thread followed by one for the logic thread
+static JobTrace *gJobTraces;
+static uint64_t gJobTraceFrameStarts[JOB_TRACE_FRAMES]; // When each logic frame started
+#endif
+
+#ifdef OCT_JOB_FIBERS
+// Fibers are created as needed and kept around for reuse
+static SDL_SpinLock gFiberLock;
+static JobFiber *gFreeFibers;
+static JobFiber *gAllFibers;
+#endif
+
+// Parking
+static SDL_Mutex *gParkMutex;
+static SDL_Condition *gParkCondition;
+static SDL_AtomicInt gParkedThreads;
+static SDL_Mutex *gWaitMutex;
+static SDL_Condition *gWaitCondition;
+static SDL_AtomicInt gAllJobsWaiters; // Threads blocked in oct_WaitJobs
+static SDL_AtomicInt gJobWaiters;     // Threads blocked in oct_WaitJob
+
+// Stats
+static JobThreadStats *gJobThreadStats;
+static double gLastStatsUpdate;       // Last time the averages were updated
+static JobThreadStats gLastStatsTotal; // Totals as of the last update
+static double gAverageWakeLatency;    // Average seconds between a job being queued and starting
+static double gParkedPercent;         // Portion of job thread time spent parked (0-1)
+
+// Injection queues, any thread may push or pop
+static InjectionQueue gInjectionQueues[OCT_JOB_PRIORITY_MAX];
+static SDL_AtomicInt gJobBacklog[OCT_JOB_PRIORITY_MAX]; // Jobs sitting in each lane's queues that haven't started
+
+////////////////////////////////// WORK-STEALING DEQUE //////////////////////////////////
+// Owner only, returns false if the deque is full
+static Oct_Bool dequePush(JobDeque *deque, JobNode *job) {
+    const uint32_t bottom = SDL_GetAtomicU32(&deque->bottom);
+    const uint32_t top = SDL_GetAtomicU32(&deque->top);
+    if (bottom - top >= JOB_DEQUE_SIZE)
+        return false;
+    deque->jobs[bottom & JOB_DEQUE_MASK] = job;
+    SDL_SetAtomicU32(&deque->bottom, bottom + 1);
+    return true;
+}
+
+// Owner only, returns null if the deque is empty (or a thief got the last job first)
+static JobNode *dequePop(JobDeque *deque) {
+    const uint32_t bottom = SDL_GetAtomicU32(&deque->bottom) - 1;
+    SDL_SetAtomicU32(&deque->bottom, bottom);
+    const uint32_t top = SDL_GetAtomicU32(&deque->top);
+
+    // Empty
+    if ((int32_t)(bottom - top) < 0) {
+        SDL_SetAtomicU32(&deque->bottom, top);
+        return null;
+    }
+
+    JobNode *job = deque->jobs[bottom & JOB_DEQUE_MASK];
+    if (bottom != top)
+        return job;
+
+    // This is the last job so we race thieves for it
+    const Oct_Bool won = SDL_CompareAndSwapAtomicU32(&deque->top, top, top + 1);
+    SDL_SetAtomicU32(&deque->bottom, top + 1);
+    return won ? job : null;
+}
+
+// Any thread, returns null if the deque is empty or another thread took the job first
+static JobNode *dequeSteal(JobDeque *deque) {
+    const uint32_t top = SDL_GetAtomicU32(&deque->top);
+    const uint32_t bottom = SDL_GetAtomicU32(&deque->bottom);
+    if ((int32_t)(bottom - top) <= 0)
+        return null;
+    JobNode *job = deque->jobs[top & JOB_DEQUE_MASK];
+    return SDL_CompareAndSwapAtomicU32(&deque->top, top, top + 1) ? job : null;
+}
+
+////////////////////////////////// INJECTION QUEUE //////////////////////////////////
+// Returns false if the queue is full
+static Oct_Bool injectionPush(InjectionQueue *queue, JobNode *job) {
+    InjectionCell *cell;
+    uint32_t pos = SDL_GetAtomicU32(&queue->tail);
+    while (true) {
+        cell = &queue->cells[pos & JOB_INJECTION_QUEUE_MASK];
+        const int32_t diff = (int32_t)(SDL_GetAtomicU32(&cell->sequence) - pos);
+        if (diff == 0) {
+            if (SDL_CompareAndSwapAtomicU32(&queue->tail, pos, pos + 1))
+                break;
+            pos = SDL_GetAtomicU32(&queue->tail);
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = SDL_GetAtomicU32(&queue->tail);
+        }
+    }
+    cell->job = job;
+    SDL_SetAtomicU32(&cell->sequence, pos + 1);
+    return true;
+}
+
+// Returns null if the queue is empty
+static JobNode *injectionPop(InjectionQueue *queue) {
+    InjectionCell *cell;
+    uint32_t pos = SDL_GetAtomicU32(&queue->head);
+    while (true) {
+        cell = &queue->cells[pos & JOB_INJECTION_QUEUE_MASK];
+        const int32_t diff = (int32_t)(SDL_GetAtomicU32(&cell->sequence) - (pos + 1));
+        if (diff == 0) {
+            if (SDL_CompareAndSwapAtomicU32(&queue->head, pos, pos + 1))
+                break;
+            pos = SDL_GetAtomicU32(&queue->head);
+        } else if (diff < 0) {
+            return null;
+        } else {
+            pos = SDL_GetAtomicU32(&queue->head);
+        }
+    }
+    JobNode *job = cell->job;
+    SDL_SetAtomicU32(&cell->sequence, pos + JOB_INJECTION_QUEUE_SIZE);
+    return job;
+}
+
+////////////////////////////////// JOB NODES //////////////////////////////////
+
+// Returns a free job node or null if the whole pool is in use
+static JobNode *reserveJobNode() {
+    const uint32_t start = SDL_AddAtomicInt(&gJobPoolCursor, 1);
+    for (uint32_t i = 0; i < JOB_POOL_SIZE; i++) {
+        JobNode *node = &gJobPool[(start + i) & JOB_POOL_MASK];
+        if (SDL_CompareAndSwapAtomicInt(&node->reserved, 0, 1))
+            return node;
+    }
+    return null;
+}
+
+static inline Oct_Job jobHandle(JobNode *node) {
+    return (uint64_t)(node - gJobPool) + (((uint64_t)SDL_GetAtomicInt(&node->generation)) << 32);
+}
+
+static inline Oct_Bool jobDone(Oct_Job job) {
+    if (job == OCT_NO_JOB)
+        return true;
+    return (uint32_t)SDL_GetAtomicInt(&gJobPool[JOB_INDEX(job) & JOB_POOL_MASK].generation) != JOB_GENERATION(job);
+}
+
+// Returns the index of the job thread this is called from, or -1 if its not a job thread
+static inline int32_t workerIndex() {
+    return (int32_t)(uintptr_t)SDL_GetTLS(&gWorkerIndex) - 1;
+}
+
+static void runJob(JobNode *node);
+
+// Wakes a parked job thread if there are any
+static inline void wakeJobThread() {
+    if (SDL_GetAtomicInt(&gParkedThreads) > 0) {
+        SDL_LockMutex(gParkMutex);
+        SDL_SignalCondition(gParkCondition);
+        SDL_UnlockMutex(gParkMutex);
+    }
+}
 
-// Ring buffer, uses a mutex because any thread can access it
-static Job gRingBuffer[JOB_RINGBUFFER_SIZE];
-static int32_t gRingBufferTail; // read head, if tail == head then there is no more data to read
-static int32_t gRingBufferHead; // write head, if head == tail - 1 the buffer is full and no more writing can be done
-static SDL_Mutex *gRingMutex;
-
-////////////////////////////////// RING BUFFER //////////////////////////////////
-// Returns false if the push fails (ring buffer full)
-static Oct_Bool ringBufferPush(Job *job) {
-    Oct_Bool cooked = true;
-    SDL_LockMutex(gRingMutex);
-    if (gRingBufferHead != (gRingBufferTail - 1) % JOB_RINGBUFFER_SIZE) {
-        // there is a spot we can write to
-        memcpy(&gRingBuffer[gRingBufferHead], job, sizeof(struct Job_t));
-        cooked = false;
-        gRingBufferHead = (gRingBufferHead + 1) % JOB_RINGBUFFER_SIZE;
-    }
-    SDL_UnlockMutex(gRingMutex);
-    return !cooked;
-}
-
-// Returns false if the pop fails (there are no jobs available)
-static Oct_Bool ringBufferPop(Job *job) {
-    Oct_Bool cooked = true;
-    SDL_LockMutex(gRingMutex);
-    if (gRingBufferTail != gRingBufferHead) {
-        // there is a spot we can read from
-        memcpy(job, &gRingBuffer[gRingBufferTail], sizeof(struct Job_t));
-        cooked = false;
-        gRingBufferTail = (gRingBufferTail + 1) % JOB_RINGBUFFER_SIZE;
-    }
-    SDL_UnlockMutex(gRingMutex);
-    return !cooked;
+// Wakes every thread blocked waiting on jobs
+static inline void wakeWaiters() {
+    SDL_LockMutex(gWaitMutex);
+    SDL_BroadcastCondition(gWaitCondition);
+    SDL_UnlockMutex(gWaitMutex);
 }
 
+// Called once for every job that was counted in gThreadsWorking when it is complete
+static inline void jobCompleted(Oct_Bool jobHasWaiters) {
+    if (SDL_AddAtomicInt(&gThreadsWorking, -1) == 1 && SDL_GetAtomicInt(&gAllJobsWaiters) > 0)
+        jobHasWaiters = true;
+    if (jobHasWaiters)
+        wakeWaiters();
+}
+
+// Puts a job whose dependencies are all complete into a queue
+static void scheduleJob(JobNode *node) {
+    node->scheduleTime = SDL_GetPerformanceCounter();
+#ifdef OCT_JOB_TRACE
+    node->traceStolen = false;
+    node->traceQueueDepth = 0;
+#endif
+
+    // Job threads push to their own deque, everyone else goes through the injection queue
+    const int32_t worker = workerIndex();
+    const Oct_JobPriority lane = node->priority;
+    SDL_AddAtomicInt(&gJobBacklog[lane], 1);
+    if ((worker >= 0 && dequePush(&gJobDeques[lane][worker], node)) || injectionPush(&gInjectionQueues[lane], node)) {
+        wakeJobThread();
+
+        // Threads asleep in oct_WaitJob may be the only ones that can run it, every job thread could be waiting
+        if (SDL_GetAtomicInt(&gJobWaiters) > 0)
+            wakeWaiters();
+        return;
+    }
+    SDL_AddAtomicInt(&gJobBacklog[lane], -1);
+
+    // If the job queues are full, the job will just be executed right away lmao
+    runJob(node);
+}
+
+// Marks a job as complete, schedules any continuations that were only waiting on it, and returns the node to the pool
+static void finishJob(JobNode *node) {
+    // Once the generation changes nobody can add new continuations
+    SDL_LockSpinlock(&node->lock);
+    JobLink *continuations = node->continuations;
+    node->continuations = null;
+    SDL_AddAtomicInt(&node->generation, 1);
+    SDL_UnlockSpinlock(&node->lock);
+    const Oct_Bool hasWaiters = SDL_GetAtomicInt(&node->waiters) > 0;
+
+    if (node->links != node->inlineLinks)
+        mi_free(node->links);
+    node->links = null;
+    SDL_SetAtomicInt(&node->reserved, 0);
+
+    // The links belong to the dependents, so grab next before a dependent can be scheduled and finish
+    while (continuations) {
+        JobLink *next = continuations->next;
+        JobNode *dependent = continuations->dependent;
+        if (SDL_AddAtomicInt(&dependent->dependencies, -1) == 1)
+            scheduleJob(dependent);
+        continuations = next;
+    }
+
+    jobCompleted(hasWaiters);
+}
+
+static void runRange(ParallelFor *parallelFor, int32_t start, int32_t end);
+
+#ifdef OCT_JOB_TRACE
+// Records a job that just ran in the calling thread's trace ring, function has to be grabbed before the job runs
+// since a parallel for is gone once its last range is done
+static void traceJob(JobNode *node, void *function, uint64_t start, uint64_t end) {
+    const int32_t slot = (int32_t)(uintptr_t)SDL_GetTLS(&gThreadSlot) - 1;
+    if (slot < 0)
+        return;
+    JobTrace *trace = &gJobTraces[slot];
+    const uint32_t count = SDL_GetAtomicU32(&trace->count);
+    JobTraceEvent *event = &trace->events[count & JOB_TRACE_EVENTS_MASK];
+    event->queued = node->scheduleTime;
+    event->start = start;
+    event->end = end;
+    event->function = function;
+    event->frame = SDL_GetAtomicU32(&gJobFrame);
+    event->queueDepth = node->traceQueueDepth;
+    event->priority = node->priority;
+    event->stolen = node->traceStolen;
+    event->parallelFor = node->parallelFor != null;
+    if (node->traceStolen)
+        SDL_SetAtomicU32(&trace->steals, SDL_GetAtomicU32(&trace->steals) + 1);
+    SDL_SetAtomicU32(&trace->count, count + 1);
+}
+#endif
+
+#ifdef OCT_JOB_TRACE
+// Text the trace is built in before it's written out in one go
+typedef struct TraceText_t {
+    char *data;
+    uint32_t size;     // Characters written, not counting the terminator
+    uint32_t capacity; // Size of data
+} TraceText;
+
+// Appends formatted text to a trace, doubling its buffer as needed
+static void traceAppend(TraceText *text, const char *fmt, ...) {
+    if (text->capacity == 0 && text->size > 0)
+        return; // Already ran out of memory
+    va_list l;
+    va_start(l, fmt);
+    const int length = SDL_vsnprintf(text->data ? text->data + text->size : null, text->capacity - text->size, fmt, l);
+    va_end(l);
+    if (length < 0 || text->size + length < text->capacity) {
+        text->size += length > 0 ? length : 0;
+        return;
+    }
+
+    uint32_t capacity = text->capacity ? text->capacity : 64 * 1024;
+    while (capacity <= text->size + length)
+        capacity *= 2;
+    char *data = mi_realloc(text->data, capacity);
+    if (!data) {
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, false, "Failed to grow the job trace to %u bytes.", capacity);
+        mi_free(text->data);
+        text->data = null;
+        text->capacity = 0;
+        return;
+    }
+    text->data = data;
+    text->capacity = capacity;
+    va_start(l, fmt);
+    SDL_vsnprintf(text->data + text->size, text->capacity - text->size, fmt, l);
+    va_end(l);
+    text->size += length;
+}
+#endif
+
+#ifdef OCT_JOB_FIBERS
+static Oct_Bool runFiber(JobNode *node);
+static void suspendFiber(JobNode *node);
+#endif
+
+static void runJob(JobNode *node) {
+#ifdef OCT_JOB_TRACE
+    void *traceFunction = node->parallelFor ? (void*)node->parallelFor->function : (void*)node->job;
+    const uint64_t start = SDL_GetPerformanceCounter();
+#endif
+    // Jobs can run nested inside other jobs that are helping out, so the outer job's key is put back after
+    Oct_DrawSortKey *previousKey = SDL_GetTLS(&gDrawSortKey);
+    SDL_SetTLS(&gDrawSortKey, &node->drawKey, null);
+    Oct_Bool finished = true;
+#ifdef OCT_JOB_FIBERS
+    if (node->fiberJob)
+        finished = runFiber(node);
+    else
+#endif
+    if (node->parallelFor)
+        runRange(node->parallelFor, node->rangeStart, node->rangeEnd);
+    else if (node->job)
+        node->job(node->ptr);
+#ifdef OCT_JOB_TRACE
+    traceJob(node, traceFunction, start, SDL_GetPerformanceCounter());
+#endif
+    SDL_SetTLS(&gDrawSortKey, previousKey, null);
+    if (finished)
+        finishJob(node);
+#ifdef OCT_JOB_FIBERS
+    else
+        suspendFiber(node);
+#endif
+}
+
+// Adds node as a continuation of job if job isn't done yet, returns true if a link was used
+static Oct_Bool addContinuation(JobNode *node, JobLink *link, Oct_Job job) {
+    if (jobDone(job))
+        return false;
+    JobNode *dependency = &gJobPool[JOB_INDEX(job) & JOB_POOL_MASK];
+    Oct_Bool added = false;
+
+    SDL_LockSpinlock(&dependency->lock);
+    if ((uint32_t)SDL_GetAtomicInt(&dependency->generation) == JOB_GENERATION(job)) {
+        link->dependent = node;
+        link->next = dependency->continuations;
+        dependency->continuations = link;
+        SDL_AddAtomicInt(&node->dependencies, 1);
+        added = true;
+    }
+    SDL_UnlockSpinlock(&dependency->lock);
+    return added;
+}
+
+#ifdef OCT_JOB_FIBERS
+////////////////////////////////// FIBERS //////////////////////////////////
+
+static void fiberEntry() {
+    JobFiber *fiber = SDL_GetTLS(&gCurrentFiber);
+    if (fiber->node->job)
+        fiber->node->job(fiber->node->ptr);
+    fiber->finished = true;
+    swapcontext(&fiber->context, fiber->returnContext);
+}
+
+// Grabs a fiber from the free list or makes a new one, then sets it up to start the job from the top
+static JobFiber *acquireFiber(JobNode *node) {
+    SDL_LockSpinlock(&gFiberLock);
+    JobFiber *fiber = gFreeFibers;
+    if (fiber)
+        gFreeFibers = fiber->next;
+    SDL_UnlockSpinlock(&gFiberLock);
+
+    if (!fiber) {
+        fiber = mi_zalloc(sizeof(struct JobFiber_t));
+        if (fiber)
+            fiber->stack = mi_malloc(JOB_FIBER_STACK_SIZE);
+        if (!fiber || !fiber->stack)
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate job fiber.");
+        SDL_LockSpinlock(&gFiberLock);
+        fiber->allNext = gAllFibers;
+        gAllFibers = fiber;
+        SDL_UnlockSpinlock(&gFiberLock);
+    }
+
+    fiber->node = node;
+    fiber->finished = false;
+    fiber->waitingOn = OCT_NO_JOB;
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = fiber->stack;
+    fiber->context.uc_stack.ss_size = JOB_FIBER_STACK_SIZE;
+    fiber->context.uc_link = null;
+    makecontext(&fiber->context, fiberEntry, 0);
+    return fiber;
+}
+
+static void releaseFiber(JobFiber *fiber) {
+    SDL_LockSpinlock(&gFiberLock);
+    fiber->next = gFreeFibers;
+    gFreeFibers = fiber;
+    SDL_UnlockSpinlock(&gFiberLock);
+}
+
+// Starts or resumes a fiber job on this thread, returns true if the job finished and false if it suspended
+static Oct_Bool runFiber(JobNode *node) {
+    if (!node->fiber)
+        node->fiber = acquireFiber(node);
+    JobFiber *fiber = node->fiber;
+
+    // Fiber jobs can run nested inside other fiber jobs that are helping out, so the previous fiber is put back after
+    ucontext_t scheduler;
+    JobFiber *previous = SDL_GetTLS(&gCurrentFiber);
+    fiber->returnContext = &scheduler;
+    SDL_SetTLS(&gCurrentFiber, fiber, null);
+    swapcontext(&scheduler, &fiber->context);
+    SDL_SetTLS(&gCurrentFiber, previous, null);
+
+    if (fiber->finished) {
+        node->fiber = null;
+        releaseFiber(fiber);
+        return true;
+    }
+    return false;
+}
+
+// Queues a suspended fiber job to be resumed once the job it is waiting on is done
+static void suspendFiber(JobNode *node) {
+    JobFiber *fiber = node->fiber;
+    SDL_SetAtomicInt(&node->dependencies, 1);
+    addContinuation(node, &fiber->link, fiber->waitingOn);
+    if (SDL_AddAtomicInt(&node->dependencies, -1) == 1)
+        scheduleJob(node);
+}
+
+// Called from inside a fiber job, returns once job is done
+static void fiberWait(JobFiber *fiber, Oct_Job job) {
+    while (!jobDone(job)) {
+        fiber->waitingOn = job;
+        swapcontext(&fiber->context, fiber->returnContext);
+    }
+}
+#endif
+
 ////////////////////////////////// INTERNAL //////////////////////////////////
 
+// Cheap per-thread random numbers for picking steal victims
+static inline uint32_t xorshift(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Looks for a job in one lane of this worker's own deque, then the injection queue, then other worker's deques,
+// worker may be -1 for threads that aren't job threads
+static JobNode *findJob(int32_t worker, Oct_JobPriority lane, uint32_t *rng) {
+    if (SDL_GetAtomicInt(&gJobBacklog[lane]) <= 0)
+        return null;
+    JobNode *job = worker >= 0 ? dequePop(&gJobDeques[lane][worker]) : null;
+    if (!job)
+        job = injectionPop(&gInjectionQueues[lane]);
+
+    // Steal from everyone else starting at a random victim
+    const uint32_t start = xorshift(rng) % gJobThreadCount;
+    for (int i = 0; i < gJobThreadCount && !job; i++) {
+        const uint32_t victim = (start + i) % gJobThreadCount;
+        if (victim != worker && (job = dequeSteal(&gJobDeques[lane][victim]))) {
+#ifdef OCT_JOB_TRACE
+            job->traceStolen = true;
+#endif
+        }
+    }
+
+    if (job) {
+        const int32_t depth = SDL_AddAtomicInt(&gJobBacklog[lane], -1) - 1;
+#ifdef OCT_JOB_TRACE
+        job->traceQueueDepth = depth;
+#else
+        (void)depth;
+#endif
+    }
+    return job;
+}
+
+// Looks for a job in every lane, critical first, starvation counts critical jobs taken while background jobs waited
+static JobNode *findAnyJob(int32_t worker, uint32_t *rng, int32_t *starvation) {
+    JobNode *job = null;
+    if (*starvation >= JOB_STARVATION_LIMIT)
+        job = findJob(worker, OCT_JOB_PRIORITY_BACKGROUND, rng);
+    if (!job)
+        job = findJob(worker, OCT_JOB_PRIORITY_CRITICAL, rng);
+    if (!job)
+        job = findJob(worker, OCT_JOB_PRIORITY_BACKGROUND, rng);
+
+    if (job && job->priority == OCT_JOB_PRIORITY_BACKGROUND)
+        *starvation = 0;
+    else if (job && SDL_GetAtomicInt(&gJobBacklog[OCT_JOB_PRIORITY_BACKGROUND]) > 0)
+        (*starvation)++;
+    return job;
+}
+
+// Runs one pending job on the calling thread if there are any, returns false if no job could be found. Threads that
+// are only helping out while they wait on frame work leave background jobs alone so they aren't held up by them,
+// unless what they wait on is itself a background job.
+static Oct_Bool runPendingJob(Oct_Bool includeBackground) {
+    uint32_t rng = (uint32_t)SDL_GetPerformanceCounter() | 1;
+    const int32_t worker = workerIndex();
+    JobNode *job = findJob(worker, OCT_JOB_PRIORITY_CRITICAL, &rng);
+    if (!job && includeBackground)
+        job = findJob(worker, OCT_JOB_PRIORITY_BACKGROUND, &rng);
+    if (job) {
+        runJob(job);
+        return true;
+    }
+    return false;
+}
+
+// Returns true if the queue jobs from this thread go into looks empty, meaning anyone looking for work would come
+// up short
+static inline Oct_Bool localQueueEmpty(int32_t worker) {
+    if (worker >= 0) {
+        JobDeque *deque = &gJobDeques[OCT_JOB_PRIORITY_CRITICAL][worker];
+        return (int32_t)(SDL_GetAtomicU32(&deque->bottom) - SDL_GetAtomicU32(&deque->top)) <= 0;
+    }
+    InjectionQueue *queue = &gInjectionQueues[OCT_JOB_PRIORITY_CRITICAL];
+    return (int32_t)(SDL_GetAtomicU32(&queue->tail) - SDL_GetAtomicU32(&queue->head)) <= 0;
+}
+
+/*
+ * Draws made from jobs are sorted by a key that belongs to whatever job or parallel for range is running, so a job
+ * helping out while it waits or a fiber job resuming on another thread can't mix up its draws with another job's.
+ * Jobs and parallel fors are numbered in the order they're queued each frame, and start out on the layer of whatever
+ * queued them. A job's index defaults to its submission index, while a parallel for keeps the index of the code that
+ * called it so its draws stay with the caller's. Submission indices are only deterministic for work queued from one
+ * thread, so jobs queued from several jobs at once should set their own key with oct_SetDrawSortKey.
+ */
+static Oct_DrawSortKey newDrawSortKey() {
+    Oct_DrawSortKey *current = SDL_GetTLS(&gDrawSortKey);
+    Oct_DrawSortKey key = {0};
+    key.submission = (uint32_t)SDL_AddAtomicInt(&gJobSubmissions, 1);
+    key.layer = current ? current->layer : 0;
+    key.index = current ? current->index : (int32_t)key.submission;
+    return key;
+}
+
+// Queues a range of a parallel for as its own job, returns false if there are no free job nodes
+static Oct_Bool queueRange(ParallelFor *parallelFor, int32_t start, int32_t end) {
+    JobNode *node = reserveJobNode();
+    if (!node)
+        return false;
+    SDL_AddAtomicInt(&gThreadsWorking, 1);
+    node->job = null;
+    node->ptr = null;
+    node->parallelFor = parallelFor;
+    node->rangeStart = start;
+    node->rangeEnd = end;
+    node->drawKey = parallelFor->drawKey;
+    node->priority = OCT_JOB_PRIORITY_CRITICAL;
+    node->fiberJob = false;
+    node->fiber = null;
+    node->continuations = null;
+    node->links = node->inlineLinks;
+    SDL_SetAtomicInt(&node->dependencies, 0);
+    scheduleJob(node);
+    return true;
+}
+
+/*
+ * Ranges are processed a grain at a time, and any time the queue this thread pushes to runs dry (meaning other
+ * threads have stolen or are about to steal everything in it) the remaining range is split in half and the back half
+ * is queued for someone else to take. If nobody is stealing, the range is never split and there is no overhead past
+ * the first check; if item cost is uneven, whichever threads finish early end up taking halves of the slow ranges.
+ */
+static void runRange(ParallelFor *parallelFor, int32_t start, int32_t end) {
+    const int32_t worker = workerIndex();
+    Oct_DrawSortKey *previousKey = SDL_GetTLS(&gDrawSortKey);
+    Oct_DrawSortKey key;
+    SDL_SetTLS(&gDrawSortKey, &key, null);
+    while (start < end) {
+        const int32_t grain = parallelFor->grain;
+        if (end - start >= grain * 2 && localQueueEmpty(worker)) {
+            const int32_t middle = start + ((end - start) / 2);
+            if (queueRange(parallelFor, middle, end)) {
+                end = middle;
+                continue;
+            }
+        }
+
+        // Once remaining is decremented for the last time parallelFor may not exist anymore
+        // Each chunk's draws are keyed by where it starts so they come out in item order however the range was split
+        const int32_t chunkEnd = end - start > grain ? start + grain : end;
+        key = parallelFor->drawKey;
+        key.range = start;
+        parallelFor->function(start, chunkEnd, parallelFor->data);
+        SDL_AddAtomicInt(&parallelFor->remaining, -(chunkEnd - start));
+        start = chunkEnd;
+    }
+    SDL_SetTLS(&gDrawSortKey, previousKey, null);
+}
+
+// Resets a scratch allocator if a new frame has started since it was last reset, owning thread only
+static void refreshScratch(JobScratch *scratch) {
+    const uint32_t frame = SDL_GetAtomicU32(&gJobFrame);
+    if (scratch->frame == frame)
+        return;
+    const int32_t used = _oct_AllocatorBytesUsed(scratch->allocator);
+    if (used > SDL_GetAtomicInt(&scratch->highWater))
+        SDL_SetAtomicInt(&scratch->highWater, used);
+    oct_ResetAllocator(scratch->allocator);
+    scratch->frame = frame;
+}
+
+// Returns true if any queue has a job in it
+static Oct_Bool anyJobsQueued() {
+    for (int i = 0; i < OCT_JOB_PRIORITY_MAX; i++)
+        if (SDL_GetAtomicInt(&gJobBacklog[i]) > 0)
+            return true;
+    return false;
+}
+
+// Sleeps until a job is queued or the engine is quitting
+static void parkJobThread(Oct_Context ctx) {
+    SDL_LockMutex(gParkMutex);
+    SDL_AddAtomicInt(&gParkedThreads, 1);
+    if (!anyJobsQueued() && !SDL_GetAtomicInt(&ctx->quit))
+        SDL_WaitCondition(gParkCondition, gParkMutex);
+    SDL_AddAtomicInt(&gParkedThreads, -1);
+    SDL_UnlockMutex(gParkMutex);
+}
+
 static int jobThread(void *ptr) {
     Oct_Context ctx = _oct_GetCtx();
-    Job job;
+    const int32_t worker = (int32_t)(uintptr_t)ptr;
+    JobThreadStats *stats = &gJobThreadStats[worker];
+    uint32_t rng = 0x9E3779B9 ^ (worker + 1);
+    int32_t spinLimit = JOB_SPIN_MIN;
+    int32_t starvation = 0;
+    SDL_SetTLS(&gWorkerIndex, (void*)(uintptr_t)(worker + 1), null);
+    SDL_SetTLS(&gThreadSlot, (void*)(uintptr_t)(worker + 1), null);
+    _oct_PinThread(OCT_THREAD_SLOT_JOBS + worker);
+
     while (!SDL_GetAtomicInt(&ctx->quit)) {
-        // Look for work
-        if (ringBufferPop(&job)) {
-            job.job(job.ptr);
-            SDL_AddAtomicInt(&gThreadsWorking, -1);
+        // Look for work, spinning for a bit if there is none
+        JobNode *job = findAnyJob(worker, &rng, &starvation);
+        for (int32_t spins = 0; !job && spins < spinLimit; spins++) {
+            SDL_CPUPauseInstruction();
+            job = findAnyJob(worker, &rng, &starvation);
+            if (job)
+                spinLimit = spinLimit * 2 > JOB_SPIN_MAX ? JOB_SPIN_MAX : spinLimit * 2;
         }
 
-        // To not totally destroy the core in the case that the job queue is empty
-        SDL_Delay(1);
+        if (job) {
+            const uint64_t start = SDL_GetPerformanceCounter();
+            stats->wakeLatency += start > job->scheduleTime ? start - job->scheduleTime : 0;
+            stats->jobsRun++;
+            refreshScratch(&gJobScratch[worker]);
+            runJob(job);
+        } else {
+            // Spinning didn't pay off, so spin less next time and sleep until there is work
+            spinLimit = spinLimit / 2 < JOB_SPIN_MIN ? JOB_SPIN_MIN : spinLimit / 2;
+            const uint64_t start = SDL_GetPerformanceCounter();
+            parkJobThread(ctx);
+            stats->parkedTime += SDL_GetPerformanceCounter() - start;
+        }
     }
     return 0;
 }
 
 void _oct_JobsInit() {
-    // Mutex
-    gRingMutex = SDL_CreateMutex();
-    if (!gRingMutex)
-        oct_Raise(OCT_STATUS_SDL_ERROR, true, "Failed to create job system rinbugger mutex, SDL error %s", SDL_GetError());
+    // Injection queue cells start out with their own index so the first lap of producers can write to them
+    for (int lane = 0; lane < OCT_JOB_PRIORITY_MAX; lane++)
+        for (uint32_t i = 0; i < JOB_INJECTION_QUEUE_SIZE; i++)
+            SDL_SetAtomicU32(&gInjectionQueues[lane].cells[i].sequence, i);
 
     // There are 4 threads in octarine: logic, render, audio, and clock. ideally we want 1 thread per core, so
     // if there are 16 cores we would have 12 job threads. If there are less cores than minimum threads + 4 we
-    // will just use the minimum.
-    int availableCoreCount = SDL_GetNumLogicalCPUCores() - 4;
-    gJobThreadCount = availableCoreCount > OCT_MINIMUM_JOB_THREADS ? availableCoreCount : OCT_MINIMUM_JOB_THREADS;
+    // will just use the minimum. The user can also just tell us how many they want. Only cores the process is
+    // allowed on count.
+    Oct_Context ctx = _oct_GetCtx();
+    const int coreCount = _oct_AllowedCoreCount();
+    if (ctx->initInfo->jobThreadCount > 0) {
+        gJobThreadCount = ctx->initInfo->jobThreadCount;
+    } else {
+        const int availableCoreCount = coreCount - 4;
+        gJobThreadCount = availableCoreCount > OCT_MINIMUM_JOB_THREADS ? availableCoreCount : OCT_MINIMUM_JOB_THREADS;
+    }
+    for (int lane = 0; lane < OCT_JOB_PRIORITY_MAX; lane++) {
+        gJobDeques[lane] = mi_zalloc(sizeof(struct JobDeque_t) * gJobThreadCount);
+        if (!gJobDeques[lane])
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate job system deques.");
+    }
+    gJobThreadStats = mi_zalloc(sizeof(struct JobThreadStats_t) * gJobThreadCount);
     gJobThreads = mi_malloc(sizeof(SDL_Thread *) * gJobThreadCount);
+    if (!gJobThreadStats || !gJobThreads)
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate job system threads.");
+
+    // Scratch memory for each job thread + the logic thread
+    gJobScratch = mi_zalloc(sizeof(struct JobScratch_t) * (gJobThreadCount + 1));
+    if (!gJobScratch)
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate job scratch memory.");
+    for (int i = 0; i < gJobThreadCount + 1; i++) {
+        gJobScratch[i].allocator = oct_CreateVirtualPageAllocator();
+        if (!gJobScratch[i].allocator)
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to create job scratch allocator.");
+    }
+
+#ifdef OCT_JOB_TRACE
+    gJobTraces = mi_zalloc(sizeof(struct JobTrace_t) * (gJobThreadCount + 1));
+    if (!gJobTraces)
+        oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate job trace buffers.");
+#endif
+
+    // Parking
+    gParkMutex = SDL_CreateMutex();
+    gParkCondition = SDL_CreateCondition();
+    gWaitMutex = SDL_CreateMutex();
+    gWaitCondition = SDL_CreateCondition();
+    if (!gParkMutex || !gParkCondition || !gWaitMutex || !gWaitCondition)
+        oct_Raise(OCT_STATUS_SDL_ERROR, true, "Failed to create job system mutexes/conditions, SDL error %s", SDL_GetError());
+
     for (int i = 0; i < gJobThreadCount; i++) {
-        gJobThreads[i] = SDL_CreateThread(jobThread, "Job thread", null);
+        gJobThreads[i] = SDL_CreateThread(jobThread, "Job thread", (void*)(uintptr_t)i);
         if (!gJobThreads[i])
             oct_Raise(OCT_STATUS_SDL_ERROR, true, "Failed to create job thread, SDL error %s", SDL_GetError());
     }
+
+    // Report the topology we ended up with
+    oct_Log("Created %i job threads (%s) on %i allowed logical cores, %i engine threads total.",
+            gJobThreadCount, ctx->initInfo->jobThreadCount > 0 ? "from init info" : "automatic", coreCount, gJobThreadCount + 4);
+    if (ctx->initInfo->pinThreads) {
+#ifdef __linux__
+        // Job threads past the allowed cores aren't pinned
+        const int32_t pinnedJobThreads = SDL_max(0, SDL_min((int32_t)gJobThreadCount, coreCount - OCT_THREAD_SLOT_JOBS));
+        char jobCores[256] = "none";
+        int32_t length = 0;
+        for (int i = 0; i < pinnedJobThreads && length < sizeof(jobCores); i++)
+            length += SDL_snprintf(jobCores + length, sizeof(jobCores) - length, i == 0 ? "%i" : ", %i", _oct_CoreForThreadSlot(OCT_THREAD_SLOT_JOBS + i));
+        oct_Log("Pinned render to core %i, logic to core %i, audio mixer to core %i, and %i job threads to cores %s, %i job threads share every allowed core.",
+                _oct_CoreForThreadSlot(OCT_THREAD_SLOT_RENDER),
+                _oct_CoreForThreadSlot(OCT_THREAD_SLOT_LOGIC),
+                _oct_CoreForThreadSlot(OCT_THREAD_SLOT_AUDIO),
+                pinnedJobThreads,
+                jobCores,
+                gJobThreadCount - pinnedJobThreads);
+#else
+        oct_Log("Thread pinning is only supported on Linux, threads were not pinned.");
+#endif
+    }
 }
 
 void _oct_JobsUpdate() {
-    // TODO: This
+    // Recalculate stats every second
+    const double time = oct_Time();
+    if (time - gLastStatsUpdate < 1)
+        return;
+    JobThreadStats total = {0};
+    for (int i = 0; i < gJobThreadCount; i++) {
+        total.jobsRun += gJobThreadStats[i].jobsRun;
+        total.wakeLatency += gJobThreadStats[i].wakeLatency;
+        total.parkedTime += gJobThreadStats[i].parkedTime;
+    }
+    const double frequency = SDL_GetPerformanceFrequency();
+    const uint64_t jobsRun = total.jobsRun - gLastStatsTotal.jobsRun;
+    gAverageWakeLatency = jobsRun > 0 ? ((double)(total.wakeLatency - gLastStatsTotal.wakeLatency) / frequency) / jobsRun : 0;
+    gParkedPercent = ((double)(total.parkedTime - gLastStatsTotal.parkedTime) / frequency) / ((time - gLastStatsUpdate) * gJobThreadCount);
+    gLastStatsTotal = total;
+    gLastStatsUpdate = time;
+}
+
+double _oct_JobsGetAverageWakeLatency() {
+    return gAverageWakeLatency;
+}
+
+double _oct_JobsGetParkedPercent() {
+    return gParkedPercent;
+}
+
+void _oct_JobsBeginFrame() {
+    // The logic thread owns the last scratch allocator
+    SDL_SetTLS(&gThreadSlot, (void*)(uintptr_t)(gJobThreadCount + 1), null);
+    SDL_SetAtomicU32(&gJobFrame, SDL_GetAtomicU32(&gJobFrame) + 1); // only the logic thread writes this
+    SDL_SetAtomicInt(&gJobSubmissions, 0);
+#ifdef OCT_JOB_TRACE
+    gJobTraceFrameStarts[SDL_GetAtomicU32(&gJobFrame) & JOB_TRACE_FRAMES_MASK] = SDL_GetPerformanceCounter();
+#endif
+    refreshScratch(&gJobScratch[gJobThreadCount]);
+}
+
+int32_t _oct_JobsGetThreadCount() {
+    return gJobThreadCount;
+}
+
+int32_t _oct_JobsThreadSlot() {
+    return (int32_t)(uintptr_t)SDL_GetTLS(&gThreadSlot) - 1;
+}
+
+Oct_Bool _oct_JobsInJob() {
+    return SDL_GetTLS(&gDrawSortKey) != null;
+}
+
+Oct_DrawSortKey *_oct_JobsDrawSortKey() {
+    return SDL_GetTLS(&gDrawSortKey);
+}
+
+int32_t _oct_JobsGetScratchHighWater(int32_t thread) {
+    return SDL_GetAtomicInt(&gJobScratch[thread].highWater);
 }
 
 void _oct_JobsEnd() {
-    SDL_DestroyMutex(gRingMutex);
+    // Parked threads need to see that the engine is quitting
+    SDL_LockMutex(gParkMutex);
+    SDL_BroadcastCondition(gParkCondition);
+    SDL_UnlockMutex(gParkMutex);
+
     for (int i = 0; i < gJobThreadCount; i++) {
         SDL_WaitThread(gJobThreads[i], NULL);
     }
+    SDL_DestroyMutex(gParkMutex);
+    SDL_DestroyCondition(gParkCondition);
+    SDL_DestroyMutex(gWaitMutex);
+    SDL_DestroyCondition(gWaitCondition);
     mi_free(gJobThreads);
+    for (int lane = 0; lane < OCT_JOB_PRIORITY_MAX; lane++)
+        mi_free(gJobDeques[lane]);
+    mi_free(gJobThreadStats);
+    for (int i = 0; i < gJobThreadCount + 1; i++)
+        oct_FreeAllocator(gJobScratch[i].allocator);
+    mi_free(gJobScratch);
+#ifdef OCT_JOB_TRACE
+    mi_free(gJobTraces);
+#endif
+#ifdef OCT_JOB_FIBERS
+    while (gAllFibers) {
+        JobFiber *next = gAllFibers->allNext;
+        mi_free(gAllFibers->stack);
+        mi_free(gAllFibers);
+        gAllFibers = next;
+    }
+#endif
 }
 
-////////////////////////////////// PUBLIC API //////////////////////////////////
+// Queues a job or fiber job once its dependencies are done
+static Oct_Job queueJob(Oct_JobFunction job, void *data, Oct_JobPriority priority, const Oct_Job *dependencies, int32_t dependencyCount, Oct_Bool fiberJob) {
+    if (priority < 0 || priority >= OCT_JOB_PRIORITY_MAX) {
+        oct_Raise(OCT_STATUS_BAD_PARAMETER, false, "Job priority %i does not exist, queueing as critical instead.", priority);
+        priority = OCT_JOB_PRIORITY_CRITICAL;
+    }
 
-OCTARINE_API void oct_QueueJob(Oct_JobFunction job, void *data) {
     // This will be decremented once this job is complete
     SDL_AddAtomicInt(&gThreadsWorking, 1);
 
-    // If the job queue is full, the job will just be executed right away lmao
-    Job jobStruct = {.job = job, .ptr = data};
-    if (!ringBufferPush(&jobStruct)) {
-        job(data);
-        SDL_AddAtomicInt(&gThreadsWorking, -1);
+    // If every job node is in use, the job will just be executed right away once its dependencies are done
+    JobNode *node = reserveJobNode();
+    if (!node) {
+        for (int i = 0; i < dependencyCount; i++)
+            oct_WaitJob(dependencies[i]);
+        if (job)
+            job(data);
+        jobCompleted(false);
+        return OCT_NO_JOB;
+    }
+
+    node->job = job;
+    node->ptr = data;
+    node->parallelFor = null;
+    node->drawKey = newDrawSortKey();
+    node->drawKey.index = (int32_t)node->drawKey.submission;
+    node->priority = priority;
+    node->fiberJob = fiberJob;
+    node->fiber = null;
+    node->continuations = null;
+    node->links = node->inlineLinks;
+    if (dependencyCount > JOB_INLINE_LINKS) {
+        node->links = mi_malloc(sizeof(struct JobLink_t) * dependencyCount);
+        if (!node->links)
+            oct_Raise(OCT_STATUS_OUT_OF_MEMORY, true, "Failed to allocate links for %i job dependencies.", dependencyCount);
+    }
+
+    // The handle has to be grabbed before the job is scheduled, it may be finished before we get to return
+    const Oct_Job handle = jobHandle(node);
+
+    // Dependencies start at 1 so the job can't be scheduled by a dependency while the rest are still being added
+    SDL_SetAtomicInt(&node->dependencies, 1);
+    int32_t linksUsed = 0;
+    for (int i = 0; i < dependencyCount; i++)
+        if (addContinuation(node, &node->links[linksUsed], dependencies[i]))
+            linksUsed++;
+    if (SDL_AddAtomicInt(&node->dependencies, -1) == 1)
+        scheduleJob(node);
+
+    return handle;
+}
+
+////////////////////////////////// PUBLIC API //////////////////////////////////
+
+OCTARINE_API Oct_Job oct_QueueJob(Oct_JobFunction job, void *data) {
+    return oct_QueueJobPriority(job, data, OCT_JOB_PRIORITY_CRITICAL, null, 0);
+}
+
+OCTARINE_API Oct_Job oct_QueueJobAfter(Oct_JobFunction job, void *data, const Oct_Job *dependencies, int32_t dependencyCount) {
+    return oct_QueueJobPriority(job, data, OCT_JOB_PRIORITY_CRITICAL, dependencies, dependencyCount);
+}
+
+OCTARINE_API Oct_Job oct_QueueJobPriority(Oct_JobFunction job, void *data, Oct_JobPriority priority, const Oct_Job *dependencies, int32_t dependencyCount) {
+    return queueJob(job, data, priority, dependencies, dependencyCount, false);
+}
+
+OCTARINE_API Oct_Job oct_QueueFiberJob(Oct_JobFunction job, void *data, Oct_JobPriority priority, const Oct_Job *dependencies, int32_t dependencyCount) {
+    return queueJob(job, data, priority, dependencies, dependencyCount, true);
+}
+
+OCTARINE_API void oct_ParallelFor(int32_t count, int32_t grain, Oct_ParallelForFunction function, void *data) {
+    if (count <= 0)
+        return;
+
+    // By default aim for a handful of ranges per thread so there is something left to steal when costs are uneven
+    if (grain <= 0) {
+        grain = count / ((int32_t)gJobThreadCount * 8);
+        if (grain < 1)
+            grain = 1;
+    }
+
+    ParallelFor parallelFor = {
+            .function = function,
+            .data = data,
+            .grain = grain,
+            .drawKey = newDrawSortKey()
+    };
+    SDL_SetAtomicInt(&parallelFor.remaining, count);
+
+    // The calling thread starts on the whole range itself and then helps out until every range is done
+    runRange(&parallelFor, 0, count);
+    while (SDL_GetAtomicInt(&parallelFor.remaining) > 0) {
+        if (!runPendingJob(false))
+            SDL_CPUPauseInstruction();
+    }
+}
+
+OCTARINE_API Oct_Bool oct_JobDone(Oct_Job job) {
+    return jobDone(job);
+}
+
+OCTARINE_API void oct_WaitJob(Oct_Job job) {
+#ifdef OCT_JOB_FIBERS
+    // Fiber jobs just get out of the way until the job is done
+    JobFiber *fiber = SDL_GetTLS(&gCurrentFiber);
+    if (fiber) {
+        fiberWait(fiber, job);
+        return;
+    }
+#endif
+
+    // Waiting on a background job means helping with background jobs too, otherwise a job thread waiting on one
+    // would never run it and every job thread doing the same would deadlock. The priority is read before checking
+    // the job is still running since the node may be reused once it's done.
+    JobNode *node = &gJobPool[JOB_INDEX(job) & JOB_POOL_MASK];
+    const Oct_Bool includeBackground = node->priority == OCT_JOB_PRIORITY_BACKGROUND;
+    while (!jobDone(job)) {
+        // Help run jobs until there are none left to take, the job being waited on may be one of them
+        if (runPendingJob(includeBackground))
+            continue;
+
+        // Whatever is left is running on other threads, so let whoever finishes the job know someone needs to be
+        // woken up and sleep until it's done or something this thread can help with is queued
+        SDL_LockMutex(gWaitMutex);
+        SDL_AddAtomicInt(&node->waiters, 1);
+        SDL_AddAtomicInt(&gJobWaiters, 1);
+        while (!jobDone(job) && SDL_GetAtomicInt(&gJobBacklog[OCT_JOB_PRIORITY_CRITICAL]) <= 0 &&
+               (!includeBackground || SDL_GetAtomicInt(&gJobBacklog[OCT_JOB_PRIORITY_BACKGROUND]) <= 0))
+            SDL_WaitCondition(gWaitCondition, gWaitMutex);
+        SDL_AddAtomicInt(&gJobWaiters, -1);
+        SDL_AddAtomicInt(&node->waiters, -1);
+        SDL_UnlockMutex(gWaitMutex);
     }
 }
 
@@ -118,5 +1193,106 @@ OCTARINE_API Oct_Bool oct_JobsBusy() {
 }
 
 OCTARINE_API void oct_WaitJobs() {
-    while (oct_JobsBusy());
+    while (oct_JobsBusy()) {
+        // The calling thread acts as another job thread until the queues are empty
+        if (runPendingJob(true))
+            continue;
+
+        // Only jobs already running on other threads are left
+        SDL_LockMutex(gWaitMutex);
+        SDL_AddAtomicInt(&gAllJobsWaiters, 1);
+        while (oct_JobsBusy() && !anyJobsQueued())
+            SDL_WaitCondition(gWaitCondition, gWaitMutex);
+        SDL_AddAtomicInt(&gAllJobsWaiters, -1);
+        SDL_UnlockMutex(gWaitMutex);
+    }
+}
+
+OCTARINE_API int32_t oct_GetJobBacklog(Oct_JobPriority priority) {
+    if (priority < 0 || priority >= OCT_JOB_PRIORITY_MAX)
+        return 0;
+    const int32_t backlog = SDL_GetAtomicInt(&gJobBacklog[priority]);
+    return backlog > 0 ? backlog : 0;
+}
+
+OCTARINE_API Oct_Allocator oct_JobScratch() {
+    const int32_t index = (int32_t)(uintptr_t)SDL_GetTLS(&gThreadSlot) - 1;
+    if (index < 0) {
+        oct_Raise(OCT_STATUS_ERROR, false, "Job scratch memory is only available from jobs and the logic thread.");
+        return null;
+    }
+    return gJobScratch[index].allocator;
+}
+
+OCTARINE_API Oct_Bool oct_DumpJobTrace(const char *filename, int32_t frames) {
+#ifdef OCT_JOB_TRACE
+    Oct_Context ctx = _oct_GetCtx();
+    if (frames < 1)
+        frames = 1;
+    if (frames > JOB_TRACE_FRAMES)
+        frames = JOB_TRACE_FRAMES;
+
+    // Chrome wants microseconds from some arbitrary start, we use game start
+    const double frequency = SDL_GetPerformanceFrequency();
+    #define TRACE_US(counter) ((double)((int64_t)((counter) - ctx->gameStartTime)) * 1000000.0 / frequency)
+    const uint32_t currentFrame = SDL_GetAtomicU32(&gJobFrame);
+    TraceText text = {0};
+    traceAppend(&text, "{\"traceEvents\":[\n");
+
+    // Thread names and frame markers
+    for (int slot = 0; slot < gJobThreadCount + 1; slot++) {
+        traceAppend(&text, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"args\":{\"name\":\"",
+                    slot == 0 ? "" : ",\n", slot);
+        if (slot == gJobThreadCount)
+            traceAppend(&text, "Logic thread");
+        else
+            traceAppend(&text, "Job thread %i", slot);
+        traceAppend(&text, " (%u steals)\"}}", SDL_GetAtomicU32(&gJobTraces[slot].steals));
+    }
+    for (int32_t i = frames - 1; i >= 0; i--) {
+        const uint32_t frame = currentFrame - i;
+        if (gJobTraceFrameStarts[frame & JOB_TRACE_FRAMES_MASK] == 0)
+            continue;
+        traceAppend(&text, ",\n{\"name\":\"Frame %u\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}",
+                    frame, TRACE_US(gJobTraceFrameStarts[frame & JOB_TRACE_FRAMES_MASK]));
+    }
+
+    // Every job from the last few frames that is still in the rings
+    for (int slot = 0; slot < gJobThreadCount + 1; slot++) {
+        JobTrace *trace = &gJobTraces[slot];
+        const uint32_t count = SDL_GetAtomicU32(&trace->count);
+        const uint32_t oldest = count > JOB_TRACE_EVENTS ? count - JOB_TRACE_EVENTS : 0;
+        for (uint32_t i = oldest; i < count; i++) {
+            JobTraceEvent *event = &trace->events[i & JOB_TRACE_EVENTS_MASK];
+            if (currentFrame - event->frame >= (uint32_t)frames)
+                continue;
+            traceAppend(&text, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f,"
+                               "\"args\":{\"function\":\"%p\",\"frame\":%u,\"queued_us\":%.3f,\"stolen\":%s,\"queue_depth\":%i}}",
+                        event->parallelFor ? "Parallel for" : "Job",
+                        event->priority == OCT_JOB_PRIORITY_BACKGROUND ? "background" : "critical",
+                        slot,
+                        TRACE_US(event->start),
+                        TRACE_US(event->end) - TRACE_US(event->start),
+                        event->function,
+                        event->frame,
+                        TRACE_US(event->start) - TRACE_US(event->queued),
+                        event->stolen ? "true" : "false",
+                        event->queueDepth);
+        }
+    }
+    #undef TRACE_US
+    traceAppend(&text, "\n]}\n");
+
+    const Oct_Bool written = text.data && oct_WriteFile(filename, text.data, text.size);
+    mi_free(text.data);
+    if (!written) {
+        oct_Raise(OCT_STATUS_FILE_DOES_NOT_EXIST, false, "Failed to write the job trace to \"%s\".", filename);
+        return false;
+    }
+    oct_Log("Wrote job trace of the last %i frames to \"%s\".", frames, filename);
+    return true;
+#else
+    oct_Raise(OCT_STATUS_ERROR, false, "Job tracing is disabled, build Octarine with OCTARINE_JOB_TRACE to use oct_DumpJobTrace.");
+    return false;
+#endif
 }
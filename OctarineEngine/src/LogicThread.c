@@ -14,6 +14,7 @@ inline static double _oct_GoofyTime(uint64_t start) {
 
 int oct_UserThread(void *ptr) {
     Oct_Context ctx = ptr;
+    _oct_PinThread(OCT_THREAD_SLOT_LOGIC);
 
     _oct_InputInit();
     void *userData = null;
@@ -31,6 +32,7 @@ int oct_UserThread(void *ptr) {
     double averageProcessTime = 0;
 
 
+    _oct_JobsBeginFrame();
     _oct_CommandBufferBeginSingleFrame();
     userData = ctx->initInfo->startup();
     _oct_CommandBufferEndSingleFrame();
@@ -41,6 +43,7 @@ int oct_UserThread(void *ptr) {
         _oct_InputUpdate();
 
         // Process user frame
+        _oct_JobsBeginFrame();
         _oct_CommandBufferBeginFrame();
         userData = ctx->initInfo->update(userData);
         _oct_CommandBufferEndFrame();
@@ -83,6 +86,7 @@ int oct_UserThread(void *ptr) {
 
 int oct_ClockThread(void *ptr) {
     Oct_Context ctx = ptr;
+    _oct_PinThread(OCT_THREAD_SLOT_NONE);
 
     // Keep track of time
     while (SDL_GetAtomicInt(&ctx->quit) == 0) {
@@ -155,21 +155,22 @@ void _oct_WindowUpdateEnd() {
     // TODO: This
 }
 
-void _oct_WindowProcessCommand(Oct_Command *cmd) {
+void _oct_WindowProcessCommand(void *command) {
     Oct_Context ctx = _oct_GetCtx();
 
-    if (OCT_STRUCTURE_TYPE(&cmd->topOfUnion) == OCT_STRUCTURE_TYPE_META_COMMAND) {
+    if (OCT_STRUCTURE_TYPE(command) == OCT_STRUCTURE_TYPE_META_COMMAND) {
         // Meta commands are currently of no interest to the windowing subsystem
     } else {
-        if (cmd->windowCommand.type == OCT_WINDOW_COMMAND_TYPE_FULLSCREEN_ENTER) {
+        Oct_WindowCommand *window = command;
+        if (window->type == OCT_WINDOW_COMMAND_TYPE_FULLSCREEN_ENTER) {
             SDL_SetWindowFullscreen(ctx->window, true);
-        } else if (cmd->windowCommand.type == OCT_WINDOW_COMMAND_TYPE_FULLSCREEN_EXIT) {
+        } else if (window->type == OCT_WINDOW_COMMAND_TYPE_FULLSCREEN_EXIT) {
             SDL_SetWindowFullscreen(ctx->window, false);
-        } else if (cmd->windowCommand.type == OCT_WINDOW_COMMAND_TYPE_FULLSCREEN_TOGGLE) {
+        } else if (window->type == OCT_WINDOW_COMMAND_TYPE_FULLSCREEN_TOGGLE) {
             Oct_Bool fs = SDL_GetWindowFlags(ctx->window) & SDL_WINDOW_FULLSCREEN;
             SDL_SetWindowFullscreen(ctx->window, !fs);
-        } else if (cmd->windowCommand.type == OCT_WINDOW_COMMAND_TYPE_RESIZE) {
-            SDL_SetWindowSize(ctx->window, cmd->windowCommand.Resize.size[0], cmd->windowCommand.Resize.size[1]);
+        } else if (window->type == OCT_WINDOW_COMMAND_TYPE_RESIZE) {
+            SDL_SetWindowSize(ctx->window, window->Resize.size[0], window->Resize.size[1]);
         }
     }
 }
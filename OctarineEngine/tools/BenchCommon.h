@@ -0,0 +1,46 @@
+/// \brief Helpers shared by the benchmarks in tools/, which run the engine headless (see _oct_StartHeadless)
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL3/SDL.h>
+#include "oct/Octarine.h"
+#include "oct/Opaque.h"
+#include "oct/Subsystems.h"
+
+/// \brief Starts the job system and command buffer with jobThreads job threads (0 picks from the core count), the
+/// calling thread counts as the logic thread
+static inline void benchStart(int argc, const char **argv, int32_t jobThreads) {
+    Oct_InitInfo initInfo = {
+            .sType = OCT_STRUCTURE_TYPE_INIT_INFO,
+            .argc = argc,
+            .argv = argv,
+            .jobThreadCount = jobThreads,
+    };
+    _oct_StartHeadless(&initInfo);
+}
+
+/// \brief Stops everything benchStart started
+static inline void benchStop() {
+    _oct_StopHeadless();
+}
+
+/// \brief Seconds since start, which came from SDL_GetPerformanceCounter
+static inline double benchSeconds(uint64_t start) {
+    return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+/// \brief Xorshift busy work that the compiler can't throw away, a few nanoseconds per iteration
+static inline uint32_t benchBusyWork(uint32_t seed, int32_t iterations) {
+    for (int32_t i = 0; i < iterations; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+    }
+    return seed;
+}
+
+/// \brief Returns true if the render thread has dispatched everything pushed into the command ring
+static inline Oct_Bool benchRingEmpty() {
+    Oct_Context ctx = _oct_GetCtx();
+    return SDL_GetAtomicInt(&ctx->RingBuffer.head) == SDL_GetAtomicInt(&ctx->RingBuffer.tail);
+}
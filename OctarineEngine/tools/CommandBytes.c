@@ -0,0 +1,127 @@
+#include "BenchCommon.h"
+
+// Measures how many bytes a frame of the demo scene in src/Game.c puts through the command ring, and how many the
+// variable-length records save over every command taking a whole Oct_Command. Every frame does what Game.c's update
+// does: a clear, a parallel for over the warriors, a sprite draw per warrior from the logic thread (this thread) and
+// a line of text. There are no assets headless so the sprite and font handles are placeholders, the renderer never
+// sees them. A separate thread plays the render thread and dispatches the whole time. The averages come from the
+// command buffer's once a second roll up, so the run lasts a bit over two of them.
+
+#define RUN_SECONDS 2.5
+
+typedef struct Warrior_t {
+    Oct_Vec2 position;
+    Oct_Vec2 velocity;
+    uint64_t id;
+} Warrior;
+
+static const Oct_Rectangle ROOM_BOUNDS = {
+        .position = {0, 0},
+        .size = {1280, 720}
+};
+
+static SDL_AtomicInt gStop; // Render thread stops once this is set and the ring is empty
+
+static float randomRange(float min, float max) {
+    return min + ((float)rand() / (float)RAND_MAX) * (max - min);
+}
+
+// Same as warriorJob in src/Game.c
+static void warriorJob(int32_t start, int32_t end, void *ptr) {
+    Warrior *warriorList = ptr;
+    for (int i = start; i < end; i++) {
+        Warrior *warrior = &warriorList[i];
+        warrior->position[0] += warrior->velocity[0];
+        warrior->position[1] += warrior->velocity[1];
+        if (warrior->position[0] < ROOM_BOUNDS.position[0] || warrior->position[0] > ROOM_BOUNDS.position[0] + ROOM_BOUNDS.size[0])
+            warrior->velocity[0] *= -1;
+        if (warrior->position[1] < ROOM_BOUNDS.position[1] || warrior->position[1] > ROOM_BOUNDS.position[1] + ROOM_BOUNDS.size[1])
+            warrior->velocity[1] *= -1;
+    }
+}
+
+static int renderThread(void *data) {
+    while (!SDL_GetAtomicInt(&gStop) || !benchRingEmpty())
+        _oct_CommandBufferDispatch();
+    return 0;
+}
+
+// What update in src/Game.c pushes, with the draw shorthands spelled out
+static void update(Warrior *warriors, int32_t count) {
+    oct_Draw(&(Oct_DrawCommand){
+            .type = OCT_DRAW_COMMAND_TYPE_CLEAR,
+            .colour = {0, 0.6, 1, 1},
+    });
+    oct_ParallelFor(count, 0, warriorJob, warriors);
+    for (int32_t i = 0; i < count; i++) {
+        oct_Draw(&(Oct_DrawCommand){
+                .type = OCT_DRAW_COMMAND_TYPE_SPRITE,
+                .colour = {1, 1, 1, 1},
+                .interpolate = OCT_INTERPOLATE_ALL,
+                .id = warriors[i].id,
+                .Sprite = {
+                        .sprite = 1,
+                        .viewport = {0, 0, OCT_WHOLE_TEXTURE, OCT_WHOLE_TEXTURE},
+                        .position = {warriors[i].position[0], warriors[i].position[1]},
+                        .scale = {1, 1},
+                        .frame = i,
+                }
+        });
+    }
+    oct_Draw(&(Oct_DrawCommand){
+            .type = OCT_DRAW_COMMAND_TYPE_FONT_ATLAS,
+            .colour = {1, 1, 1, 1},
+            .FontAtlas = {
+                    .atlas = 2,
+                    .scale = 1,
+                    .position = {320, 250},
+                    .text = "The quick brown fox jumps over the lazy dog.\n!@#$%^&*()_+-={}[]"
+            }
+    });
+}
+
+int main(int argc, const char **argv) {
+    const int32_t warriorCount = argc >= 2 ? atoi(argv[1]) : 5000;
+    if (warriorCount < 1) {
+        printf("Usage: %s [warriors, 5000 is what src/Game.c draws]\n", argv[0]);
+        return 1;
+    }
+    benchStart(argc, argv, 0);
+    Warrior *warriors = malloc(sizeof(struct Warrior_t) * warriorCount);
+    for (int32_t i = 0; i < warriorCount; i++) {
+        warriors[i].id = 1000 + i;
+        warriors[i].position[0] = randomRange(ROOM_BOUNDS.position[0], ROOM_BOUNDS.size[0]);
+        warriors[i].position[1] = randomRange(ROOM_BOUNDS.position[1], ROOM_BOUNDS.size[1]);
+        warriors[i].velocity[0] = randomRange(-3, 3);
+        warriors[i].velocity[1] = randomRange(-3, 3);
+    }
+    SDL_Thread *render = SDL_CreateThread(renderThread, "Render", null);
+    if (!render) {
+        printf("Failed to create render thread, SDL error %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // Same frame the logic thread in oct_Init runs, minus input and the frame cap
+    int64_t frames = 0;
+    const uint64_t start = SDL_GetPerformanceCounter();
+    while (benchSeconds(start) < RUN_SECONDS) {
+        _oct_JobsBeginFrame();
+        _oct_CommandBufferBeginFrame();
+        update(warriors, warriorCount);
+        _oct_CommandBufferEndFrame();
+        frames++;
+    }
+    SDL_SetAtomicInt(&gStop, 1);
+    SDL_WaitThread(render, null);
+
+    const double bytes = _oct_CommandBufferGetAverageBytesPerFrame();
+    const double saved = _oct_CommandBufferGetAverageBytesSavedPerFrame();
+    printf("%i warriors, %lli frames in %.1fs\n", warriorCount, (long long)frames, RUN_SECONDS);
+    printf("Oct_Command is %i bytes\n", (int)sizeof(struct Oct_Command_t));
+    printf("Bytes per frame:       %12.0f\n", bytes);
+    printf("Bytes saved per frame: %12.0f (%.1f%% of the fixed-size encoding)\n", saved,
+           bytes + saved > 0 ? (saved / (bytes + saved)) * 100 : 0);
+    free(warriors);
+    benchStop();
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "BenchCommon.h"
+
+// Measures how the command ring holds up with 1 to N threads pushing into it at once. Every producer is a plain
+// thread (not a job) so each oct_Draw goes straight to the ring and fights the others for the tail. This thread
+// plays the render thread and dispatches the whole time, headless dispatch skips the renderer so the consumer side
+// costs about as little as it can and the producers are what's being measured. Throughput is every command pushed
+// over the time from the producers starting to the ring being empty again.
+
+#define MAX_PRODUCERS 256
+
+static SDL_AtomicInt gStart;   // Producers spin on this so they all start together
+static SDL_AtomicInt gRunning; // Producers that haven't pushed everything yet
+static int32_t gPushes;        // Commands each producer pushes
+
+static int producer(void *data) {
+    const int32_t index = (int32_t)(uintptr_t)data;
+    while (!SDL_GetAtomicInt(&gStart))
+        SDL_CPUPauseInstruction();
+    for (int32_t i = 0; i < gPushes; i++) {
+        oct_Draw(&(Oct_DrawCommand){
+                .type = OCT_DRAW_COMMAND_TYPE_RECTANGLE,
+                .colour = {1, 1, 1, 1},
+                .id = ((uint64_t)index << 32) | (uint32_t)i,
+                .Rectangle = {
+                        .rectangle = {.position = {(float)(i % 640), (float)index}, .size = {8, 8}},
+                        .filled = true,
+                },
+        });
+    }
+    SDL_AddAtomicInt(&gRunning, -1);
+    return 0;
+}
+
+// Seconds it takes the producer threads to push everything and the ring to drain
+static double run(int32_t producers) {
+    SDL_Thread *threads[MAX_PRODUCERS];
+    SDL_SetAtomicInt(&gStart, 0);
+    SDL_SetAtomicInt(&gRunning, producers);
+    for (int32_t i = 0; i < producers; i++) {
+        threads[i] = SDL_CreateThread(producer, "Producer", (void*)(uintptr_t)i);
+        if (!threads[i]) {
+            printf("Failed to create producer thread, SDL error %s\n", SDL_GetError());
+            exit(1);
+        }
+    }
+
+    const uint64_t start = SDL_GetPerformanceCounter();
+    SDL_SetAtomicInt(&gStart, 1);
+    while (SDL_GetAtomicInt(&gRunning) > 0 || !benchRingEmpty())
+        _oct_CommandBufferDispatch();
+    const double seconds = benchSeconds(start);
+
+    for (int32_t i = 0; i < producers; i++)
+        SDL_WaitThread(threads[i], null);
+    return seconds;
+}
+
+int main(int argc, const char **argv) {
+    const int32_t maxProducers = argc >= 2 ? atoi(argv[1]) : 16;
+    gPushes = argc >= 3 ? atoi(argv[2]) : 200000;
+    if (maxProducers < 1 || maxProducers > MAX_PRODUCERS || gPushes < 1) {
+        printf("Usage: %s [max producers] [commands per producer]\n", argv[0]);
+        return 1;
+    }
+    printf("%i commands per producer on %i logical cores\n", gPushes, SDL_GetNumLogicalCPUCores());
+    printf("producers  commands/s  per producer  ns per push  ring bytes\n");
+
+    for (int32_t producers = 1;; producers = SDL_min(producers * 2, maxProducers)) {
+        benchStart(argc, argv, 1);
+        const double seconds = run(producers);
+        const int32_t capacity = _oct_GetCtx()->RingBuffer.capacity; // Bigger than it started if the ring had to grow
+        benchStop();
+
+        // ns per push is how long each producer spent on a push, including any time the ring was full
+        const double rate = ((double)producers * gPushes) / seconds;
+        printf("%9i  %10.0f  %12.0f  %11.1f  %10i\n", producers, rate, rate / producers,
+               (seconds * 1000000000.0) / gPushes, capacity);
+        if (producers == maxProducers)
+            break;
+    }
+    return 0;
+}
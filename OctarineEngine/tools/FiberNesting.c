@@ -0,0 +1,133 @@
+#include "BenchCommon.h"
+
+// Runs nested fork/join work with regular jobs and with fiber jobs to show where waiting inside a job ties up job
+// threads. Every parent job queues its children, does some work of its own, and then calls oct_WaitJob on each of
+// its children. Leaves only do busy work.
+//  - tree: a deep tree where every job is critical, regular jobs get through it by running other jobs nested inside
+//    their waits but end up sleeping whenever what they wait on is running elsewhere
+//  - background: more critical parents than job threads, each waiting on background children. Once every job thread
+//    is holding a parent the children can only run on the parents' own threads, so regular parents have to run them
+//    inside oct_WaitJob while fiber parents suspend and free the thread for them. Parents hold off on forking until
+//    every job thread has one (or a second passes), which is the worst case a multi-core machine can land in on
+//    its own.
+// The logic thread (this thread) only polls so it can't rescue anything. A run that doesn't finish within the timeout
+// means the job threads deadlocked, it's reported as stalled, the logic thread finishes it with oct_WaitJobs so the
+// tool can exit, and the tool fails.
+
+#define TIMEOUT_SECONDS 5
+#define MAX_FANOUT 16
+#define LEAF_WORK 20000 // Iterations of busy work per leaf, tens of microseconds
+#define PARENT_WORK 200000 // Iterations of busy work a parent does between forking and joining, under a millisecond
+#define LINE_UP_MS 1000 // Longest a parent waits for the other job threads to pick up parents
+
+typedef struct Scenario_t {
+    const char *name;
+    Oct_Bool fibers;              // Parents are fiber jobs
+    Oct_JobPriority rootPriority; // Lane the roots go in
+    Oct_JobPriority childPriority; // Lane every other job goes in
+    int32_t roots;                // Jobs the logic thread queues
+    int32_t depth;                // Levels of parents under each root
+    int32_t fanout;               // Children each parent waits on
+    Oct_Bool lineUp;              // Roots wait for every job thread to be holding one before they join
+} Scenario;
+
+static Scenario gScenario;
+static SDL_AtomicInt gLeavesRun;
+static SDL_AtomicInt gRootsStarted;
+static SDL_AtomicInt gChecksum;
+
+static void nodeJob(void *data);
+
+static Oct_Job queueNode(int32_t depth, Oct_JobPriority priority) {
+    // Only jobs that wait need a fiber
+    if (gScenario.fibers && depth > 0)
+        return oct_QueueFiberJob(nodeJob, (void*)(uintptr_t)depth, priority, null, 0);
+    return oct_QueueJobPriority(nodeJob, (void*)(uintptr_t)depth, priority, null, 0);
+}
+
+static void nodeJob(void *data) {
+    const int32_t depth = (int32_t)(uintptr_t)data;
+    if (depth == 0) {
+        SDL_AddAtomicInt(&gChecksum, (int)benchBusyWork(SDL_AddAtomicInt(&gLeavesRun, 1) + 1, LEAF_WORK));
+        return;
+    }
+    if (gScenario.lineUp && depth == gScenario.depth) {
+        const int32_t lineUp = SDL_min(gScenario.roots, _oct_JobsGetThreadCount());
+        const uint64_t giveUp = SDL_GetPerformanceCounter() + (LINE_UP_MS * SDL_GetPerformanceFrequency()) / 1000;
+        SDL_AddAtomicInt(&gRootsStarted, 1);
+        while (SDL_GetAtomicInt(&gRootsStarted) < lineUp && SDL_GetPerformanceCounter() < giveUp)
+            SDL_Delay(1);
+    }
+    Oct_Job children[MAX_FANOUT];
+    for (int32_t i = 0; i < gScenario.fanout; i++)
+        children[i] = queueNode(depth - 1, gScenario.childPriority);
+    SDL_AddAtomicInt(&gChecksum, (int)benchBusyWork(depth, PARENT_WORK));
+    for (int32_t i = 0; i < gScenario.fanout; i++)
+        oct_WaitJob(children[i]);
+}
+
+static int32_t leafCount(const Scenario *scenario) {
+    int32_t leaves = scenario->roots;
+    for (int32_t i = 0; i < scenario->depth; i++)
+        leaves *= scenario->fanout;
+    return leaves;
+}
+
+// Returns false if the scenario stalled
+static Oct_Bool runScenario(const Scenario *scenario) {
+    gScenario = *scenario;
+    SDL_SetAtomicInt(&gLeavesRun, 0);
+    SDL_SetAtomicInt(&gRootsStarted, 0);
+    Oct_Job roots[64];
+    const uint64_t start = SDL_GetPerformanceCounter();
+    _oct_JobsBeginFrame();
+    for (int32_t i = 0; i < scenario->roots; i++)
+        roots[i] = queueNode(scenario->depth, scenario->rootPriority);
+
+    // Poll so the logic thread doesn't help
+    Oct_Bool done = false;
+    const uint64_t timeout = start + TIMEOUT_SECONDS * SDL_GetPerformanceFrequency();
+    while (!done && SDL_GetPerformanceCounter() < timeout) {
+        SDL_Delay(1);
+        done = true;
+        for (int32_t i = 0; i < scenario->roots; i++)
+            done = done && oct_JobDone(roots[i]);
+    }
+    const double seconds = benchSeconds(start);
+    const int32_t leavesRun = SDL_GetAtomicInt(&gLeavesRun);
+    if (done) {
+        printf("%-10s  %-7s  %6i  %9.1f ms  finished\n", scenario->name, scenario->fibers ? "fiber" : "regular",
+               leafCount(scenario), seconds * 1000);
+    } else {
+        oct_WaitJobs();
+        printf("%-10s  %-7s  %6i  %9s     stalled, %i leaves had run after %is, oct_WaitJobs finished it in %.1f ms\n",
+               scenario->name, scenario->fibers ? "fiber" : "regular", leafCount(scenario), "-", leavesRun,
+               TIMEOUT_SECONDS, (benchSeconds(start) - seconds) * 1000);
+    }
+    return done;
+}
+
+int main(int argc, const char **argv) {
+    const int32_t threads = argc >= 2 ? atoi(argv[1]) : 0;
+    if (threads < 0) {
+        printf("Usage: %s [job threads, 0 picks from the core count]\n", argv[0]);
+        return 1;
+    }
+    benchStart(argc, argv, threads);
+    const int32_t jobThreads = _oct_JobsGetThreadCount();
+    printf("%i job threads on %i logical cores\n", jobThreads, SDL_GetNumLogicalCPUCores());
+    printf("%-10s  %-7s  %6s  %12s\n", "scenario", "jobs", "leaves", "time");
+
+    const int32_t parents = SDL_min(jobThreads * 2, 64);
+    const Scenario scenarios[] = {
+            {"tree", false, OCT_JOB_PRIORITY_CRITICAL, OCT_JOB_PRIORITY_CRITICAL, 4, 3, 8, false},
+            {"tree", true, OCT_JOB_PRIORITY_CRITICAL, OCT_JOB_PRIORITY_CRITICAL, 4, 3, 8, false},
+            {"background", false, OCT_JOB_PRIORITY_CRITICAL, OCT_JOB_PRIORITY_BACKGROUND, parents, 1, 8, true},
+            {"background", true, OCT_JOB_PRIORITY_CRITICAL, OCT_JOB_PRIORITY_BACKGROUND, parents, 1, 8, true},
+    };
+    Oct_Bool finished = true;
+    for (int i = 0; i < sizeof(scenarios) / sizeof(Scenario); i++)
+        finished = runScenario(&scenarios[i]) && finished;
+    benchStop();
+    return finished ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include "BenchCommon.h"
+
+// Measures how job throughput scales from 1 to N job threads. Every round queues a burst of small jobs from the
+// "logic thread" (this thread) with oct_QueueJob and waits on them with oct_WaitJobs, then does the same amount of
+// work through oct_ParallelFor. The logic thread helps while it waits, so 1 job thread means 2 threads doing work.
+
+#define ROUNDS 50
+#define WORK_PER_JOB 2000 // Iterations of busy work per job, a few microseconds
+#define MAX_THREADS 256
+
+// Counted per thread so the counting doesn't become the contention being measured
+typedef struct ThreadCounter_t {
+    int64_t jobsRun;
+    uint32_t checksum; // Keeps the busy work from being optimized out
+    uint8_t padding[64 - sizeof(int64_t) - sizeof(uint32_t)];
+} ThreadCounter;
+static ThreadCounter gCounters[MAX_THREADS + 1];
+
+static void job(void *data) {
+    ThreadCounter *counter = &gCounters[_oct_JobsThreadSlot()];
+    counter->checksum += benchBusyWork((uint32_t)(uintptr_t)data + 1, WORK_PER_JOB);
+    counter->jobsRun++;
+}
+
+static int64_t jobsRun() {
+    int64_t total = 0;
+    for (int i = 0; i <= MAX_THREADS; i++)
+        total += gCounters[i].jobsRun;
+    return total;
+}
+
+static void range(int32_t start, int32_t end, void *data) {
+    for (int32_t i = start; i < end; i++)
+        job((void*)(uintptr_t)i);
+}
+
+// Seconds it takes to get through every round
+static double runJobs(int32_t jobs) {
+    const uint64_t start = SDL_GetPerformanceCounter();
+    for (int round = 0; round < ROUNDS; round++) {
+        _oct_JobsBeginFrame();
+        for (int32_t i = 0; i < jobs; i++)
+            oct_QueueJob(job, (void*)(uintptr_t)i);
+        oct_WaitJobs();
+    }
+    return benchSeconds(start);
+}
+
+static double runParallelFor(int32_t jobs) {
+    const uint64_t start = SDL_GetPerformanceCounter();
+    for (int round = 0; round < ROUNDS; round++) {
+        _oct_JobsBeginFrame();
+        oct_ParallelFor(jobs, 0, range, null);
+    }
+    return benchSeconds(start);
+}
+
+int main(int argc, const char **argv) {
+    const int32_t maxThreads = argc >= 2 ? atoi(argv[1]) : SDL_GetNumLogicalCPUCores();
+    const int32_t jobs = argc >= 3 ? atoi(argv[2]) : 2048;
+    if (maxThreads < 1 || maxThreads > MAX_THREADS || jobs < 1) {
+        printf("Usage: %s [max job threads] [jobs per round]\n", argv[0]);
+        return 1;
+    }
+    printf("%i rounds of %i jobs on %i logical cores\n", ROUNDS, jobs, SDL_GetNumLogicalCPUCores());
+    printf("threads  queue jobs/s  speedup  parallel for jobs/s  speedup\n");
+
+    double baseQueue = 0;
+    double baseParallelFor = 0;
+    for (int32_t threads = 1;; threads = SDL_min(threads * 2, maxThreads)) {
+        benchStart(argc, argv, threads);
+        SDL_memset(gCounters, 0, sizeof(gCounters));
+        const double queueRate = (ROUNDS * (double)jobs) / runJobs(jobs);
+        const double parallelForRate = (ROUNDS * (double)jobs) / runParallelFor(jobs);
+        const int64_t ran = jobsRun();
+        benchStop();
+        if (ran != (int64_t)ROUNDS * jobs * 2) {
+            printf("Only %lli of %lli jobs ran with %i threads\n", (long long)ran, (long long)ROUNDS * jobs * 2, threads);
+            return 1;
+        }
+
+        if (threads == 1) {
+            baseQueue = queueRate;
+            baseParallelFor = parallelForRate;
+        }
+        printf("%7i  %12.0f  %6.2fx  %19.0f  %6.2fx\n", threads, queueRate, queueRate / baseQueue, parallelForRate, parallelForRate / baseParallelFor);
+        if (threads == maxThreads)
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <time.h>
+#include "BenchCommon.h"
+
+// Measures what job threads cost while there's nothing to do and how long they take to pick up a job. Idle CPU is
+// the process's CPU time over a stretch with no jobs at all, and again while the logic thread (this thread) sits in
+// oct_WaitJobs on a job that only sleeps. Wake-to-run latency is the time from oct_QueueJob to the job starting, with
+// the job threads still spinning from the last job ("hot") or long since parked ("parked"). The caller never waits
+// with oct_WaitJob since that would run the job itself.
+
+#define IDLE_SECONDS 2
+#define HOT_SAMPLES 2000
+#define PARKED_SAMPLES 200
+#define PARKED_GAP_MS 20 // Long enough for every job thread to give up spinning and park
+
+static double gQueueTime;
+
+static double now() {
+    return (double)SDL_GetPerformanceCounter() / SDL_GetPerformanceFrequency();
+}
+
+// Percent of one core the whole process used while running idle
+static double cpuWhile(void (*idle)()) {
+    const clock_t startCPU = clock();
+    const double start = now();
+    idle();
+    return (((double)(clock() - startCPU) / CLOCKS_PER_SEC) / (now() - start)) * 100;
+}
+
+static void sleepIdle() {
+    SDL_Delay(IDLE_SECONDS * 1000);
+}
+
+static void sleepJob(void *data) {
+    SDL_Delay(IDLE_SECONDS * 1000);
+}
+
+static void waitIdle() {
+    oct_QueueJob(sleepJob, null);
+    oct_WaitJobs();
+}
+
+static void latencyJob(void *data) {
+    *(double*)data = now() - gQueueTime;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Queues samples jobs one at a time and prints percentiles of how long each took to start
+static void measureLatency(const char *name, int32_t samples, int32_t gap) {
+    double *latencies = malloc(sizeof(double) * samples);
+    for (int32_t i = 0; i < samples; i++) {
+        if (gap > 0)
+            SDL_Delay(gap);
+        gQueueTime = now();
+        Oct_Job job = oct_QueueJob(latencyJob, &latencies[i]);
+        while (!oct_JobDone(job))
+            SDL_CPUPauseInstruction();
+    }
+    qsort(latencies, samples, sizeof(double), compareDoubles);
+    printf("%-7s  %8.1f  %8.1f  %8.1f  %8.1f\n", name, latencies[samples / 2] * 1000000,
+           latencies[(samples * 9) / 10] * 1000000, latencies[(samples * 99) / 100] * 1000000,
+           latencies[samples - 1] * 1000000);
+    free(latencies);
+}
+
+int main(int argc, const char **argv) {
+    const int32_t threads = argc >= 2 ? atoi(argv[1]) : 0;
+    if (threads < 0) {
+        printf("Usage: %s [job threads, 0 picks from the core count]\n", argv[0]);
+        return 1;
+    }
+    benchStart(argc, argv, threads);
+    printf("%i job threads on %i logical cores\n", _oct_JobsGetThreadCount(), SDL_GetNumLogicalCPUCores());
+
+    // Let the threads settle into parking before measuring idle
+    SDL_Delay(100);
+    printf("Idle CPU with no jobs:            %6.2f%% of a core\n", cpuWhile(sleepIdle));
+    printf("Idle CPU blocked in oct_WaitJobs: %6.2f%% of a core\n\n", cpuWhile(waitIdle));
+
+    printf("Wake-to-run latency in microseconds\n");
+    printf("         %8s  %8s  %8s  %8s\n", "p50", "p90", "p99", "max");
+    measureLatency("hot", HOT_SAMPLES, 0);
+    measureLatency("parked", PARKED_SAMPLES, PARKED_GAP_MS);
+    benchStop();
+    return 0;
+}
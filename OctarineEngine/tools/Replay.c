@@ -0,0 +1,27 @@
+#include <stdio.h>
+#include <string.h>
+#include "oct/Octarine.h"
+
+// Replays a command capture made with Oct_InitInfo::captureFile and reports how long each frame took to render
+int main(int argc, const char **argv) {
+    if (argc < 2) {
+        printf("Usage: %s <capture file> [timings csv] [--debug]\n", argv[0]);
+        return 1;
+    }
+    const char *timingsFile = argc >= 3 && strcmp(argv[2], "--debug") != 0 ? argv[2] : null;
+    Oct_Bool debug = false;
+    for (int i = 2; i < argc; i++)
+        if (strcmp(argv[i], "--debug") == 0)
+            debug = true;
+
+    Oct_InitInfo initInfo = {
+            .sType = OCT_STRUCTURE_TYPE_INIT_INFO,
+            .argc = argc,
+            .argv = argv,
+            .windowTitle = "Octarine Replay",
+            .windowWidth = 1280,
+            .windowHeight = 720,
+            .debug = debug,
+    };
+    return oct_Replay(&initInfo, argv[1], timingsFile) == OCT_STATUS_SUCCESS ? 0 : 1;
+}
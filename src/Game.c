@@ -24,18 +24,11 @@ const Oct_Rectangle ROOM_BOUNDS = {
         .size = {1280, 720}
 };
 
-// Info needed for each warrior job
-typedef struct WarriorJobInfo_t {
-    int startingIndex;
-    int length;
-    Warrior *warriorList;
-} WarriorJobInfo;
-
 // Updates a group of warriors
-void warriorJob(void *ptr) {
-    WarriorJobInfo *info = ptr;
-    for (int i = info->startingIndex; i < info->startingIndex + info->length; i++) {
-        Warrior *warrior = &info->warriorList[i];
+void warriorJob(int32_t start, int32_t end, void *ptr) {
+    Warrior *warriorList = ptr;
+    for (int i = start; i < end; i++) {
+        Warrior *warrior = &warriorList[i];
         warrior->position[0] += warrior->velocity[0];
         warrior->position[1] += warrior->velocity[1];
         if (warrior->position[0] < ROOM_BOUNDS.position[0] || warrior->position[0] > ROOM_BOUNDS.position[0] + ROOM_BOUNDS.size[0])
@@ -72,17 +65,9 @@ void *update(void *ptr) {
     oct_DrawClear(&(Oct_Colour){0, 0.6, 1, 1});
 
     // Update warriors
-    const int jobCount = 10;
-    WarriorJobInfo jobInfo[10] = {0};
-    for (int i = 0; i < jobCount; i++) {
-        jobInfo[i].warriorList = gWarriorList;
-        jobInfo[i].length = WARRIOR_COUNT / jobCount;
-        jobInfo[i].startingIndex = (WARRIOR_COUNT / jobCount) * i;
-        oct_QueueJob(warriorJob, &jobInfo[i]);
-    }
+    oct_ParallelFor(WARRIOR_COUNT, 0, warriorJob, gWarriorList);
 
     // Draw warriors
-    oct_WaitJobs();
     for (int i = 0; i < WARRIOR_COUNT; i++) {
         oct_DrawSpriteInt(OCT_INTERPOLATE_ALL, gWarriorList[i].id, gSprPaladinWalkRight, &gWarriorList[i].sprite, gWarriorList[i].position);
     }